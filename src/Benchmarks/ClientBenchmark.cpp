@@ -0,0 +1,384 @@
+#include "MPointer.h"
+#include "LinkedList.h"
+#include "MVector.h"
+#include "MArray.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+
+struct BenchmarkConfig {
+    std::string address = "localhost:50051";
+    std::string unixSocket; // When set, compare per-op latency over TCP and the socket
+    bool compareShared = false; // Compare per-op latency over gRPC and the shared arena
+    std::vector<int> listSizes;  // When set, time building LinkedLists of these sizes
+    std::vector<int> compareSizes; // When set, compare MVector with LinkedList at these sizes
+    std::string snapshotPath; // When set, time a server snapshot written to this path
+    std::vector<std::string> shardAddresses; // When set, scale over 1..N of these servers
+    int threads = 8;
+    int opsPerThread = 5000;
+    std::vector<size_t> connectionCounts = {1, 2, 4, 8};
+    ChannelSelection selection = ChannelSelection::RoundRobin;
+};
+
+void printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " [--address ADDR] [--threads N] [--ops N] [--connections N] [--affinity] [--unix PATH] [--shared] [--list [SIZES]] [--compare [SIZES]] [--snapshot FILE] [--shards ADDRS]" << std::endl;
+    std::cout << "  ADDR: Memory Manager address (default localhost:50051)" << std::endl;
+    std::cout << "  --threads: Client threads issuing Get calls" << std::endl;
+    std::cout << "  --ops: Get calls per thread" << std::endl;
+    std::cout << "  --connections: Channel pool size (default: sweep 1, 2, 4, 8)" << std::endl;
+    std::cout << "  --affinity: Pin each thread to one channel instead of round-robin" << std::endl;
+    std::cout << "  --unix: Compare single-thread latency over ADDR and the Unix socket at PATH" << std::endl;
+    std::cout << "  --list: Build LinkedLists of comma-separated SIZES (default 1000,10000,100000) and report RPCs and time" << std::endl;
+    std::cout << "  --compare: Build an MVector and a LinkedList of each of SIZES (default 1000,10000) and time indexed reads" << std::endl;
+    std::cout << "  --snapshot: Have the server write a snapshot to FILE (for mem-mgr --restore) and report its bandwidth" << std::endl;
+    std::cout << "  --shards: Comma-separated Memory Managers, report Get throughput and capacity over the first 1..N of them" << std::endl;
+    std::cout << "  --shared: Compare single-thread latency over gRPC and the server's shared arena (mem-mgr --shm)" << std::endl;
+}
+
+// Reads one pointer per thread in a loop and returns the achieved Get calls/s
+double runThroughput(const BenchmarkConfig& config) {
+    std::vector<MPointer<int>> pointers;
+    for (int t = 0; t < config.threads; ++t) {
+        pointers.push_back(MPointer<int>::New());
+        pointers.back() = t;
+    }
+    
+    std::atomic<int> failures(0);
+    auto start = std::chrono::steady_clock::now();
+    
+    std::vector<std::thread> workers;
+    for (int t = 0; t < config.threads; ++t) {
+        workers.emplace_back([&, t]() {
+            MPointer<int>& ptr = pointers[t];
+            for (int i = 0; i < config.opsPerThread; ++i) {
+                try {
+                    if (*ptr != t) {
+                        failures++;
+                    }
+                } catch (const std::exception&) {
+                    failures++;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (failures > 0) {
+        std::cerr << failures << " operations failed" << std::endl;
+    }
+    
+    return (1.0 * config.threads * config.opsPerThread) / elapsed;
+}
+
+// Issues sequential Get calls from one thread and returns the mean latency in microseconds
+double runLatency(const std::string& address, int ops, bool sharedMemory = false) {
+    GRPCClient& client = GRPCClient::getInstance();
+    client.Disconnect();
+    client.SetPoolSize(1);
+    client.SetSharedMemory(sharedMemory);
+    if (!client.Connect(address) || client.IsSharedMemoryMapped() != sharedMemory) {
+        return -1;
+    }
+    
+    MPointer<int> ptr = MPointer<int>::New();
+    ptr = 7;
+    
+    // Warm up the connection before timing
+    for (int i = 0; i < ops / 10; ++i) {
+        *ptr;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ops; ++i) {
+        *ptr;
+    }
+    auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    
+    return elapsed / ops;
+}
+
+// Parses a comma-separated list of sizes
+std::vector<int> parseSizes(const std::string& sizes) {
+    std::vector<int> result;
+    size_t start = 0;
+    while (start < sizes.size()) {
+        size_t comma = sizes.find(',', start);
+        if (comma == std::string::npos) {
+            comma = sizes.size();
+        }
+        result.push_back(std::atoi(sizes.substr(start, comma - start).c_str()));
+        start = comma + 1;
+    }
+    return result;
+}
+
+// Builds one list per size with add() and reports RPCs and wall time
+void runListBuild(const std::vector<int>& sizes) {
+    GRPCClient& client = GRPCClient::getInstance();
+    
+    std::cout << std::setw(10) << "elements" << std::setw(12) << "RPCs" << std::setw(14) << "RPCs/add"
+              << std::setw(12) << "seconds" << std::endl;
+    for (int size : sizes) {
+        LinkedList<int> list;
+        
+        client.ResetRpcCount();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < size; ++i) {
+            list.add(i);
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        uint64_t rpcs = client.GetRpcCount();
+        
+        std::cout << std::setw(10) << size << std::setw(12) << rpcs << std::setw(14) << std::fixed
+                  << std::setprecision(2) << (static_cast<double>(rpcs) / size) << std::setw(12)
+                  << std::setprecision(3) << elapsed << std::endl;
+    }
+}
+
+// Times building each container and reading every element by index
+void runContainerCompare(const std::vector<int>& sizes) {
+    GRPCClient& client = GRPCClient::getInstance();
+    
+    std::cout << std::setw(12) << "container" << std::setw(10) << "elements" << std::setw(12) << "build RPCs"
+              << std::setw(12) << "build s" << std::setw(12) << "read RPCs" << std::setw(12) << "read s" << std::endl;
+    auto report = [](const char* name, int size, uint64_t buildRpcs, double buildTime, uint64_t readRpcs, double readTime) {
+        std::cout << std::setw(12) << name << std::setw(10) << size << std::setw(12) << buildRpcs << std::setw(12)
+                  << std::fixed << std::setprecision(3) << buildTime << std::setw(12) << readRpcs << std::setw(12)
+                  << readTime << std::endl;
+    };
+    
+    for (int size : sizes) {
+        MVector<int> vec;
+        client.ResetRpcCount();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < size; ++i) {
+            vec.push_back(i);
+        }
+        double buildTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        uint64_t buildRpcs = client.GetRpcCount();
+        
+        client.ResetRpcCount();
+        start = std::chrono::steady_clock::now();
+        long long sum = 0;
+        for (int i = 0; i < size; ++i) {
+            sum += vec[i];
+        }
+        double readTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        report("MVector", size, buildRpcs, buildTime, client.GetRpcCount(), readTime);
+        
+        LinkedList<int> list;
+        client.ResetRpcCount();
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < size; ++i) {
+            list.add(i);
+        }
+        buildTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        buildRpcs = client.GetRpcCount();
+        
+        // Each get walks the chain on the server from the head
+        client.ResetRpcCount();
+        start = std::chrono::steady_clock::now();
+        long long listSum = 0;
+        for (int i = 0; i < size; ++i) {
+            listSum += list.get(i);
+        }
+        readTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        report("LinkedList", size, buildRpcs, buildTime, client.GetRpcCount(), readTime);
+        
+        if (sum != listSum) {
+            std::cerr << "Containers disagree on the contents" << std::endl;
+        }
+    }
+}
+
+// Connects to the first 1..N servers in turn and reports Get throughput
+// and how many 1MB blocks fit before every arena is full
+void runShardScaling(const BenchmarkConfig& config) {
+    GRPCClient& client = GRPCClient::getInstance();
+    const size_t BLOCK_SIZE = 1024 * 1024;
+    
+    std::cout << "Threads: " << config.threads << ", Get calls per thread: " << config.opsPerThread << std::endl;
+    std::cout << std::setw(10) << "servers" << std::setw(16) << "ops/s" << std::setw(16) << "capacity MB" << std::endl;
+    
+    std::vector<std::string> addresses;
+    for (const std::string& address : config.shardAddresses) {
+        addresses.push_back(address);
+        client.Disconnect();
+        client.SetPoolSize(config.connectionCounts.back());
+        if (!client.Connect(addresses)) {
+            return;
+        }
+        
+        double opsPerSecond = runThroughput(config);
+        
+        std::vector<MArray<char>> blocks;
+        try {
+            while (true) {
+                blocks.push_back(MArray<char>::New(BLOCK_SIZE));
+            }
+        } catch (const std::exception&) {
+            // Every server is full
+        }
+        
+        std::cout << std::setw(10) << addresses.size() << std::setw(16) << std::fixed << std::setprecision(0)
+                  << opsPerSecond << std::setw(16) << blocks.size() << std::endl;
+        
+        // Give the collectors a cycle to reclaim the blocks before the next round
+        blocks.clear();
+        std::this_thread::sleep_for(std::chrono::seconds(2));
+    }
+    client.Disconnect();
+}
+
+int main(int argc, char** argv) {
+    BenchmarkConfig config;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        
+        if (arg == "--address" && hasValue) {
+            config.address = argv[++i];
+        } else if (arg == "--threads" && hasValue) {
+            config.threads = std::atoi(argv[++i]);
+        } else if (arg == "--ops" && hasValue) {
+            config.opsPerThread = std::atoi(argv[++i]);
+        } else if (arg == "--connections" && hasValue) {
+            config.connectionCounts = {static_cast<size_t>(std::atoi(argv[++i]))};
+        } else if (arg == "--affinity") {
+            config.selection = ChannelSelection::ThreadAffinity;
+        } else if (arg == "--unix" && hasValue) {
+            config.unixSocket = argv[++i];
+        } else if (arg == "--snapshot" && hasValue) {
+            config.snapshotPath = argv[++i];
+        } else if (arg == "--shards" && hasValue) {
+            std::string addresses = argv[++i];
+            size_t start = 0;
+            while (start < addresses.size()) {
+                size_t comma = addresses.find(',', start);
+                if (comma == std::string::npos) {
+                    comma = addresses.size();
+                }
+                config.shardAddresses.push_back(addresses.substr(start, comma - start));
+                start = comma + 1;
+            }
+        } else if (arg == "--shared") {
+            config.compareShared = true;
+        } else if (arg == "--list") {
+            config.listSizes = {1000, 10000, 100000};
+            if (hasValue && argv[i + 1][0] != '-') {
+                config.listSizes = parseSizes(argv[++i]);
+            }
+        } else if (arg == "--compare") {
+            config.compareSizes = {1000, 10000};
+            if (hasValue && argv[i + 1][0] != '-') {
+                config.compareSizes = parseSizes(argv[++i]);
+            }
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    
+    GRPCClient& client = GRPCClient::getInstance();
+    client.SetChannelSelection(config.selection);
+    
+    if (!config.listSizes.empty()) {
+        client.SetPoolSize(1);
+        if (!client.Connect(config.address)) {
+            return 1;
+        }
+        runListBuild(config.listSizes);
+        client.Disconnect();
+        return 0;
+    }
+    
+    if (!config.shardAddresses.empty()) {
+        runShardScaling(config);
+        return 0;
+    }
+    
+    if (!config.snapshotPath.empty()) {
+        if (!client.Connect(config.address)) {
+            return 1;
+        }
+        auto start = std::chrono::steady_clock::now();
+        long long bytes = client.Snapshot(config.snapshotPath);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        client.Disconnect();
+        if (bytes < 0) {
+            return 1;
+        }
+        
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "Snapshot " << config.snapshotPath << ": " << (bytes / (1024.0 * 1024.0)) << " MB in "
+                  << elapsed << " s (" << (bytes / (1024.0 * 1024.0) / elapsed) << " MB/s)" << std::endl;
+        return 0;
+    }
+    
+    if (!config.compareSizes.empty()) {
+        client.SetPoolSize(1);
+        if (!client.Connect(config.address)) {
+            return 1;
+        }
+        runContainerCompare(config.compareSizes);
+        client.Disconnect();
+        return 0;
+    }
+    
+    if (config.compareShared) {
+        double rpcLatency = runLatency(config.address, config.opsPerThread);
+        double sharedLatency = runLatency(config.address, config.opsPerThread, true);
+        client.Disconnect();
+        if (rpcLatency < 0 || sharedLatency < 0) {
+            std::cerr << "Shared arena not available, start mem-mgr with --shm on this host" << std::endl;
+            return 1;
+        }
+        
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "Get latency over gRPC: " << rpcLatency << " us/op" << std::endl;
+        std::cout << "Get latency over the shared arena: " << sharedLatency << " us/op" << std::endl;
+        return 0;
+    }
+    
+    if (!config.unixSocket.empty()) {
+        double tcpLatency = runLatency(config.address, config.opsPerThread);
+        double unixLatency = runLatency("unix:" + config.unixSocket, config.opsPerThread);
+        client.Disconnect();
+        if (tcpLatency < 0 || unixLatency < 0) {
+            return 1;
+        }
+        
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "Get latency over " << config.address << ": " << tcpLatency << " us/op" << std::endl;
+        std::cout << "Get latency over unix:" << config.unixSocket << ": " << unixLatency << " us/op" << std::endl;
+        std::cout << "Reduction: " << (100.0 * (tcpLatency - unixLatency) / tcpLatency) << "%" << std::endl;
+        return 0;
+    }
+    
+    std::cout << "Threads: " << config.threads << ", Get calls per thread: " << config.opsPerThread << std::endl;
+    std::cout << std::setw(12) << "connections" << std::setw(16) << "ops/s" << std::endl;
+    
+    for (size_t connections : config.connectionCounts) {
+        client.Disconnect();
+        client.SetPoolSize(connections);
+        if (!client.Connect(config.address)) {
+            return 1;
+        }
+        
+        double opsPerSecond = runThroughput(config);
+        std::cout << std::setw(12) << connections << std::setw(16) << std::fixed << std::setprecision(0)
+                  << opsPerSecond << std::endl;
+    }
+    
+    client.Disconnect();
+    return 0;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Log-linear histogram in the style of HdrHistogram. Values below 128 get a
+// bucket each, above that every power of two is split in 64 buckets, so a
+// value is reported within 1/64 (about 1.6%) of what was recorded over the
+// whole 64-bit range. Fixed size and recording is one increment, so each
+// thread keeps its own and they are merged at the end
+class LatencyHistogram {
+public:
+    LatencyHistogram() : counts(BUCKET_COUNT, 0), total(0), maxValue(0) {}
+    
+    void Record(uint64_t value) {
+        counts[BucketOf(value)]++;
+        total++;
+        maxValue = std::max(maxValue, value);
+    }
+    
+    void Merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+    
+    uint64_t Count() const { return total; }
+    uint64_t Max() const { return maxValue; }
+    
+    // Highest value equivalent to the one at quantile (0..1], 0 when empty
+    uint64_t Percentile(double quantile) const {
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * total)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(HighestOf(i), maxValue);
+            }
+        }
+        return maxValue;
+    }
+    
+private:
+    static constexpr int SUB_BUCKET_BITS = 7;
+    static constexpr uint64_t SUB_BUCKETS = 1ULL << SUB_BUCKET_BITS;
+    static constexpr uint64_t HALF_BUCKETS = SUB_BUCKETS / 2;
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKETS + (64 - SUB_BUCKET_BITS) * HALF_BUCKETS;
+    
+    static size_t BucketOf(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return value;
+        }
+        // Keep the leading one and the SUB_BUCKET_BITS - 1 bits below it
+        int shift = 63 - __builtin_clzll(value) - (SUB_BUCKET_BITS - 1);
+        return SUB_BUCKETS + (shift - 1) * HALF_BUCKETS + ((value >> shift) - HALF_BUCKETS);
+    }
+    
+    static uint64_t HighestOf(size_t bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        int shift = static_cast<int>((bucket - SUB_BUCKETS) / HALF_BUCKETS) + 1;
+        uint64_t top = (bucket - SUB_BUCKETS) % HALF_BUCKETS + HALF_BUCKETS;
+        return ((top + 1) << shift) - 1;
+    }
+    
+    std::vector<uint64_t> counts;
+    uint64_t total;
+    uint64_t maxValue;
+};
@@ -0,0 +1,365 @@
+#include "GRPCClient.h"
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+
+// Drives a running Memory Manager with a fixed mix of Get, Set and Create
+// calls and reports throughput and latency percentiles, so a change can be
+// judged against the same workload before and after:
+//
+//   mpointers-loadgen --threads 8 --connections 4 --mix get=90,set=10 --sizes 64,4096 --qps 20000
+//
+// Without --qps every thread issues its next call as soon as the previous
+// one returns (closed loop). With --qps calls are started on a fixed schedule
+// and latency is measured from the scheduled start, so a stalled server is
+// charged for the calls that queued up behind it instead of hiding them.
+
+using Clock = std::chrono::steady_clock;
+
+enum Operation { OP_GET = 0, OP_SET = 1, OP_CREATE = 2, OP_COUNT = 3 };
+const char* const OPERATION_NAMES[OP_COUNT] = {"get", "set", "create"};
+
+// Blocks each thread keeps from its Creates before releasing the oldest
+constexpr size_t CREATED_LIMIT = 64;
+
+struct LoadConfig {
+    std::string address = "localhost:50051";
+    std::string tenant;
+    int threads = 8;
+    size_t connections = 4;
+    ChannelSelection selection = ChannelSelection::RoundRobin;
+    bool sharedMemory = false;
+    double qps = 0; // Target calls/s over all threads, 0 for closed loop
+    double duration = 10;
+    double warmup = 1;
+    int keys = 1000;
+    std::vector<size_t> valueSizes = {64};
+    int weights[OP_COUNT] = {90, 10, 0};
+    unsigned seed = 1;
+};
+
+// Blocks the Get and Set calls pick from, created before the run
+struct Key {
+    int64_t id;
+    size_t size;
+};
+
+struct WorkerResult {
+    LatencyHistogram latency[OP_COUNT]; // Nanoseconds
+    uint64_t errors[OP_COUNT] = {};
+    Clock::time_point lastEnd; // When the last recorded call returned
+};
+
+void printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " [--address ADDR] [--threads N] [--connections N] [--affinity] [--qps N] [--duration S] [--warmup S] [--mix MIX] [--sizes SIZES] [--keys N] [--tenant NAME] [--shared] [--seed N]" << std::endl;
+    std::cout << "  ADDR: Memory Manager address, or a comma-separated list of them (default localhost:50051)" << std::endl;
+    std::cout << "  --threads: Client threads issuing calls (default 8)" << std::endl;
+    std::cout << "  --connections: Channel pool size (default 4)" << std::endl;
+    std::cout << "  --affinity: Pin each thread to one channel instead of round-robin" << std::endl;
+    std::cout << "  --qps: Open loop at this total rate of calls/s (default: closed loop)" << std::endl;
+    std::cout << "  --duration: Seconds measured (default 10)" << std::endl;
+    std::cout << "  --warmup: Seconds run before measuring (default 1)" << std::endl;
+    std::cout << "  --mix: Relative weights of get, set and create, e.g. get=80,set=15,create=5 (default get=90,set=10)" << std::endl;
+    std::cout << "  --sizes: Comma-separated value sizes in bytes, each block and Create picks one (default 64)" << std::endl;
+    std::cout << "  --keys: Blocks the Get and Set calls spread over (default 1000)" << std::endl;
+    std::cout << "  --tenant: Tenant arena to load (mem-mgr --tenant)" << std::endl;
+    std::cout << "  --shared: Let Get and Set use the server's shared arena (mem-mgr --shm)" << std::endl;
+    std::cout << "  --seed: Seed of the key, size and operation choices (default 1)" << std::endl;
+}
+
+// Parses a comma-separated list of sizes
+std::vector<size_t> parseSizes(const std::string& sizes) {
+    std::vector<size_t> result;
+    size_t start = 0;
+    while (start < sizes.size()) {
+        size_t comma = sizes.find(',', start);
+        if (comma == std::string::npos) {
+            comma = sizes.size();
+        }
+        result.push_back(std::strtoull(sizes.substr(start, comma - start).c_str(), nullptr, 10));
+        start = comma + 1;
+    }
+    return result;
+}
+
+// Parses name=weight pairs, operations left out get weight 0
+bool parseMix(const std::string& mix, int weights[OP_COUNT]) {
+    std::fill(weights, weights + OP_COUNT, 0);
+    size_t start = 0;
+    while (start < mix.size()) {
+        size_t comma = mix.find(',', start);
+        if (comma == std::string::npos) {
+            comma = mix.size();
+        }
+        std::string entry = mix.substr(start, comma - start);
+        size_t equals = entry.find('=');
+        if (equals == std::string::npos) {
+            return false;
+        }
+        std::string name = entry.substr(0, equals);
+        int weight = std::atoi(entry.substr(equals + 1).c_str());
+        int op = 0;
+        while (op < OP_COUNT && name != OPERATION_NAMES[op]) {
+            op++;
+        }
+        if (op == OP_COUNT || weight < 0) {
+            return false;
+        }
+        weights[op] = weight;
+        start = comma + 1;
+    }
+    int total = 0;
+    for (int op = 0; op < OP_COUNT; ++op) {
+        total += weights[op];
+    }
+    return total > 0;
+}
+
+// Creates the blocks Get and Set work on and fills them
+bool createKeys(const LoadConfig& config, std::vector<Key>& keys) {
+    GRPCClient& client = GRPCClient::getInstance();
+    std::mt19937 random(config.seed);
+    for (int i = 0; i < config.keys; ++i) {
+        size_t size = config.valueSizes[random() % config.valueSizes.size()];
+        int64_t id = client.Create(size, TypeDescriptorOf<char>());
+        if (id < 0) {
+            return false;
+        }
+        std::string value(size, static_cast<char>('a' + i % 26));
+        if (!client.Set(id, value.data(), value.size())) {
+            return false;
+        }
+        keys.push_back(Key{id, size});
+    }
+    return true;
+}
+
+// Issues calls from start until end, recording the ones started after measureFrom
+void runWorker(const LoadConfig& config, const std::vector<Key>& keys, int thread, Clock::time_point start,
+               Clock::time_point measureFrom, Clock::time_point end, WorkerResult& result) {
+    GRPCClient& client = GRPCClient::getInstance();
+    std::mt19937 random(config.seed + 1 + thread);
+    
+    size_t maxSize = 0;
+    for (size_t size : config.valueSizes) {
+        maxSize = std::max(maxSize, size);
+    }
+    std::string buffer(maxSize, static_cast<char>('A' + thread % 26));
+    std::deque<int64_t> created;
+    
+    int totalWeight = 0;
+    for (int op = 0; op < OP_COUNT; ++op) {
+        totalWeight += config.weights[op];
+    }
+    
+    // Open loop: threads share the rate and start staggered over one interval
+    std::chrono::nanoseconds interval(0);
+    Clock::time_point scheduled = start;
+    if (config.qps > 0) {
+        interval = std::chrono::nanoseconds(static_cast<int64_t>(1e9 * config.threads / config.qps));
+        scheduled += interval * thread / config.threads;
+    }
+    
+    while (true) {
+        Clock::time_point opStart;
+        if (config.qps > 0) {
+            std::this_thread::sleep_until(scheduled);
+            opStart = scheduled;
+            scheduled += interval;
+        } else {
+            opStart = Clock::now();
+        }
+        if (opStart >= end) {
+            break;
+        }
+        
+        int pick = static_cast<int>(random() % totalWeight);
+        int op = 0;
+        while (pick >= config.weights[op]) {
+            pick -= config.weights[op];
+            op++;
+        }
+        
+        bool ok = true;
+        const Key& key = keys[random() % keys.size()];
+        if (op == OP_GET) {
+            size_t actualSize = 0;
+            ok = client.Get(key.id, &buffer[0], key.size, actualSize);
+        } else if (op == OP_SET) {
+            ok = client.Set(key.id, buffer.data(), key.size);
+        } else {
+            int64_t id = client.Create(config.valueSizes[random() % config.valueSizes.size()], TypeDescriptorOf<char>());
+            ok = id >= 0;
+            if (ok) {
+                created.push_back(id);
+            }
+        }
+        Clock::time_point opEnd = Clock::now();
+        
+        if (opStart >= measureFrom) {
+            result.latency[op].Record(std::chrono::duration_cast<std::chrono::nanoseconds>(opEnd - opStart).count());
+            result.lastEnd = opEnd;
+            if (!ok) {
+                result.errors[op]++;
+            }
+        }
+        
+        // Keep the arena from filling up, the release is not timed
+        if (created.size() > CREATED_LIMIT) {
+            client.DecreaseRefCount(created.front());
+            created.pop_front();
+        }
+    }
+    
+    for (int64_t id : created) {
+        client.DecreaseRefCount(id);
+    }
+}
+
+void printRow(const char* name, const LatencyHistogram& latency, uint64_t errors, double elapsed) {
+    auto micros = [](uint64_t nanos) { return nanos / 1000.0; };
+    std::cout << std::setw(8) << name << std::setw(12) << latency.Count() << std::setw(8) << errors
+              << std::setw(12) << std::fixed << std::setprecision(0) << (latency.Count() / elapsed)
+              << std::setprecision(1) << std::setw(10) << micros(latency.Percentile(0.50))
+              << std::setw(10) << micros(latency.Percentile(0.99)) << std::setw(10)
+              << micros(latency.Percentile(0.999)) << std::setw(10) << micros(latency.Max()) << std::endl;
+}
+
+int main(int argc, char** argv) {
+    LoadConfig config;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        
+        if (arg == "--address" && hasValue) {
+            config.address = argv[++i];
+        } else if (arg == "--threads" && hasValue) {
+            config.threads = std::atoi(argv[++i]);
+        } else if (arg == "--connections" && hasValue) {
+            config.connections = static_cast<size_t>(std::atoi(argv[++i]));
+        } else if (arg == "--affinity") {
+            config.selection = ChannelSelection::ThreadAffinity;
+        } else if (arg == "--qps" && hasValue) {
+            config.qps = std::atof(argv[++i]);
+        } else if (arg == "--duration" && hasValue) {
+            config.duration = std::atof(argv[++i]);
+        } else if (arg == "--warmup" && hasValue) {
+            config.warmup = std::atof(argv[++i]);
+        } else if (arg == "--mix" && hasValue) {
+            if (!parseMix(argv[++i], config.weights)) {
+                std::cerr << "Invalid --mix " << argv[i] << ", expected e.g. get=80,set=15,create=5" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--sizes" && hasValue) {
+            config.valueSizes = parseSizes(argv[++i]);
+        } else if (arg == "--keys" && hasValue) {
+            config.keys = std::atoi(argv[++i]);
+        } else if (arg == "--tenant" && hasValue) {
+            config.tenant = argv[++i];
+        } else if (arg == "--shared") {
+            config.sharedMemory = true;
+        } else if (arg == "--seed" && hasValue) {
+            config.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    
+    bool sizesValid = !config.valueSizes.empty();
+    for (size_t size : config.valueSizes) {
+        sizesValid = sizesValid && size > 0;
+    }
+    if (config.threads <= 0 || config.connections == 0 || config.duration <= 0 || config.warmup < 0 ||
+        config.keys <= 0 || config.qps < 0 || !sizesValid) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    GRPCClient& client = GRPCClient::getInstance();
+    client.SetPoolSize(config.connections);
+    client.SetChannelSelection(config.selection);
+    client.SetSharedMemory(config.sharedMemory);
+    client.SetTenant(config.tenant);
+    if (!client.Connect(config.address)) {
+        return 1;
+    }
+    
+    std::vector<Key> keys;
+    if (!createKeys(config, keys)) {
+        std::cerr << "Failed to create the " << config.keys << " blocks of the working set" << std::endl;
+        client.Disconnect();
+        return 1;
+    }
+    
+    Clock::time_point start = Clock::now();
+    Clock::time_point measureFrom = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(config.warmup));
+    Clock::time_point end = measureFrom + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(config.duration));
+    
+    std::vector<WorkerResult> results(config.threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < config.threads; ++t) {
+        workers.emplace_back(runWorker, std::cref(config), std::cref(keys), t, start, measureFrom, end,
+                             std::ref(results[t]));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    for (const Key& key : keys) {
+        client.DecreaseRefCount(key.id);
+    }
+    client.Disconnect();
+    
+    LatencyHistogram total;
+    LatencyHistogram perOp[OP_COUNT];
+    uint64_t errors[OP_COUNT] = {};
+    uint64_t totalErrors = 0;
+    Clock::time_point lastEnd = end;
+    for (const WorkerResult& result : results) {
+        lastEnd = std::max(lastEnd, result.lastEnd);
+        for (int op = 0; op < OP_COUNT; ++op) {
+            perOp[op].Merge(result.latency[op]);
+            total.Merge(result.latency[op]);
+            errors[op] += result.errors[op];
+            totalErrors += result.errors[op];
+        }
+    }
+    
+    std::cout << "Threads: " << config.threads << ", connections: " << config.connections << ", keys: "
+              << config.keys << ", mix: get=" << config.weights[OP_GET] << ",set=" << config.weights[OP_SET]
+              << ",create=" << config.weights[OP_CREATE] << std::endl;
+    // Calls still in flight at the end count against throughput, so an
+    // overloaded server shows up as a rate below the target
+    double elapsed = std::chrono::duration<double>(lastEnd - measureFrom).count();
+    std::cout << std::fixed << std::setprecision(0);
+    if (config.qps > 0) {
+        std::cout << "Open loop, target " << config.qps << " calls/s, achieved " << (total.Count() / elapsed)
+                  << " calls/s" << std::endl;
+    } else {
+        std::cout << "Closed loop, " << (total.Count() / elapsed) << " calls/s" << std::endl;
+    }
+    
+    std::cout << std::setw(8) << "op" << std::setw(12) << "calls" << std::setw(8) << "errors" << std::setw(12)
+              << "calls/s" << std::setw(10) << "p50 us" << std::setw(10) << "p99 us" << std::setw(10) << "p999 us"
+              << std::setw(10) << "max us" << std::endl;
+    for (int op = 0; op < OP_COUNT; ++op) {
+        if (config.weights[op] > 0) {
+            printRow(OPERATION_NAMES[op], perOp[op], errors[op], elapsed);
+        }
+    }
+    printRow("all", total, totalErrors, elapsed);
+    
+    return totalErrors > 0 ? 1 : 0;
+}
@@ -0,0 +1,186 @@
+#include "MemoryManagerModel.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+// In-process benchmarks of MemoryManagerModel, no gRPC involved. Compare runs
+// across commits with the JSON output:
+//
+//   mem-mgr-bench --benchmark_out=model.json --benchmark_out_format=json
+//
+// The first argument of every benchmark is the number of live blocks. Heaps
+// stay small because every Create sorts the block list, so building one of
+// n blocks is O(n^2 log n); the benchmarks that rebuild the heap for every
+// measurement run a fixed number of iterations.
+
+namespace {
+
+constexpr size_t BLOCK_SIZE = 64;
+
+// Fragmentation patterns for the blocks freed before compaction
+enum FreePattern { EVERY_OTHER = 0, FRONT_HALF = 1, RANDOM_HALF = 2 };
+
+// A model holding count blocks of BLOCK_SIZE, with room for as many more
+std::unique_ptr<MemoryManagerModel> MakeHeap(size_t count, std::vector<int64_t>& ids) {
+    auto model = std::make_unique<MemoryManagerModel>(2 * count * BLOCK_SIZE + BLOCK_SIZE);
+    ids.clear();
+    for (size_t i = 0; i < count; ++i) {
+        ids.push_back(model->Create(BLOCK_SIZE, "block"));
+    }
+    return model;
+}
+
+// Drop the last reference to half of the blocks
+void ReleaseHalf(MemoryManagerModel& model, const std::vector<int64_t>& ids, FreePattern pattern) {
+    std::mt19937 random(42);
+    for (size_t i = 0; i < ids.size(); ++i) {
+        bool release = pattern == EVERY_OTHER ? i % 2 == 0 :
+                       pattern == FRONT_HALF ? i < ids.size() / 2 : random() % 2 == 0;
+        if (release) {
+            model.DecreaseRefCount(ids[i]);
+        }
+    }
+}
+
+void BM_Create(benchmark::State& state) {
+    size_t count = state.range(0);
+    std::vector<int64_t> ids;
+    auto model = MakeHeap(count, ids);
+    size_t created = 0;
+    for (auto _ : state) {
+        if (created == count) {
+            // The arena is full, start over from count live blocks
+            state.PauseTiming();
+            model = MakeHeap(count, ids);
+            created = 0;
+            state.ResumeTiming();
+        }
+        benchmark::DoNotOptimize(model->Create(BLOCK_SIZE, "block"));
+        created++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_SetGet(benchmark::State& state) {
+    std::vector<int64_t> ids;
+    auto model = MakeHeap(state.range(0), ids);
+    std::mt19937 random(42);
+    char value[BLOCK_SIZE] = {};
+    for (auto _ : state) {
+        int64_t id = ids[random() % ids.size()];
+        size_t actualSize = 0;
+        model->Set(id, value, sizeof(value));
+        model->Get(id, value, sizeof(value), actualSize);
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetItemsProcessed(2 * state.iterations());
+    state.SetBytesProcessed(2 * state.iterations() * BLOCK_SIZE);
+}
+
+void BM_RefCount(benchmark::State& state) {
+    std::vector<int64_t> ids;
+    auto model = MakeHeap(state.range(0), ids);
+    std::mt19937 random(42);
+    for (auto _ : state) {
+        int64_t id = ids[random() % ids.size()];
+        model->IncreaseRefCount(id);
+        model->DecreaseRefCount(id);
+    }
+    state.SetItemsProcessed(2 * state.iterations());
+}
+
+// Steady-state collector pass over live blocks, nothing to free
+void BM_CollectGarbageIdle(benchmark::State& state) {
+    std::vector<int64_t> ids;
+    auto model = MakeHeap(state.range(0), ids);
+    for (auto _ : state) {
+        model->CollectGarbage();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Collector pass that frees half of the blocks
+void BM_CollectGarbage(benchmark::State& state) {
+    std::vector<int64_t> ids;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto model = MakeHeap(state.range(0), ids);
+        ReleaseHalf(*model, ids, static_cast<FreePattern>(state.range(1)));
+        state.ResumeTiming();
+        
+        model->CollectGarbage();
+        
+        state.PauseTiming();
+        model.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Compaction after half of the blocks were freed in the given pattern
+void BM_Defragment(benchmark::State& state) {
+    std::vector<int64_t> ids;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto model = MakeHeap(state.range(0), ids);
+        ReleaseHalf(*model, ids, static_cast<FreePattern>(state.range(1)));
+        model->CollectGarbage();
+        state.ResumeTiming();
+        
+        model->Defragment();
+        
+        state.PauseTiming();
+        model.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Create into a full, fragmented arena: the first fit fails and the
+// allocation pays for the compaction
+void BM_CreateFragmented(benchmark::State& state) {
+    std::vector<int64_t> ids;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto model = MakeHeap(state.range(0), ids);
+        while (model->Create(BLOCK_SIZE, "block") != -1) {
+        }
+        ReleaseHalf(*model, ids, static_cast<FreePattern>(state.range(1)));
+        model->CollectGarbage();
+        state.ResumeTiming();
+        
+        benchmark::DoNotOptimize(model->Create(2 * BLOCK_SIZE, "block"));
+        
+        state.PauseTiming();
+        model.reset();
+        state.ResumeTiming();
+    }
+}
+
+constexpr int REBUILD_ITERATIONS = 20;
+
+void HeapSizes(benchmark::internal::Benchmark* benchmark) {
+    benchmark->RangeMultiplier(8)->Range(64, 4096);
+}
+
+void HeapSizesAndPatterns(benchmark::internal::Benchmark* benchmark) {
+    for (int64_t count : {256, 1024, 4096}) {
+        for (int pattern : {EVERY_OTHER, FRONT_HALF, RANDOM_HALF}) {
+            benchmark->Args({count, pattern});
+        }
+    }
+    benchmark->ArgNames({"blocks", "pattern"})->Iterations(REBUILD_ITERATIONS);
+}
+
+} // namespace
+
+BENCHMARK(BM_Create)->Apply(HeapSizes);
+BENCHMARK(BM_SetGet)->Apply(HeapSizes);
+BENCHMARK(BM_RefCount)->Apply(HeapSizes);
+BENCHMARK(BM_CollectGarbageIdle)->Apply(HeapSizes);
+BENCHMARK(BM_CollectGarbage)->Apply(HeapSizesAndPatterns)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Defragment)->Apply(HeapSizesAndPatterns)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CreateFragmented)->Apply(HeapSizesAndPatterns)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Read-modify-write operations on a 4- or 8-byte word inside a block.
+// Callers serialize access (the server holds its memory lock and the
+// block's shared slot, clients hold the shared slot), so the word is
+// updated with plain loads and stores.
+
+enum class BlockAtomicOp {
+    FetchAdd,
+    CompareExchange,
+    Exchange
+};
+
+inline bool IsValidAtomicWord(size_t offset, size_t width, size_t blockSize) {
+    return (width == 4 || width == 8) && offset % width == 0 && offset <= blockSize && width <= blockSize - offset;
+}
+
+template <typename Word>
+inline int64_t ApplyAtomicWord(char* address, BlockAtomicOp op, int64_t operand, int64_t expected) {
+    Word previous;
+    memcpy(&previous, address, sizeof(Word));
+
+    Word result = previous;
+    switch (op) {
+        case BlockAtomicOp::FetchAdd:
+            // Add as unsigned so overflow wraps instead of being undefined
+            result = static_cast<Word>(static_cast<uint64_t>(previous) + static_cast<uint64_t>(operand));
+            break;
+        case BlockAtomicOp::CompareExchange:
+            if (previous == static_cast<Word>(expected)) {
+                result = static_cast<Word>(operand);
+            }
+            break;
+        case BlockAtomicOp::Exchange:
+            result = static_cast<Word>(operand);
+            break;
+    }
+
+    memcpy(address, &result, sizeof(Word));
+    return previous;
+}
+
+// Applies op to the word at address and returns its previous value (sign-extended)
+inline int64_t ApplyBlockAtomic(char* address, BlockAtomicOp op, size_t width, int64_t operand, int64_t expected) {
+    if (width == 4) {
+        return ApplyAtomicWord<int32_t>(address, op, operand, expected);
+    }
+    return ApplyAtomicWord<int64_t>(address, op, operand, expected);
+}
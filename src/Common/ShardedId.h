@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+// A client connected to several Memory Managers hands out block and region
+// ids that carry the index of the owning server in their high bits, so any
+// later call goes straight to that server. Ids from a single server are
+// used unchanged.
+//
+//     [0][shard: 6 bits][id on that server: 57 bits]
+constexpr int SHARD_ID_BITS = 57;
+constexpr int MAX_SHARDS = 64;
+constexpr int64_t LOCAL_ID_MASK = (int64_t(1) << SHARD_ID_BITS) - 1;
+
+inline int ShardOfId(int64_t id) {
+    return id > 0 ? static_cast<int>(id >> SHARD_ID_BITS) : 0;
+}
+
+inline int64_t LocalIdOf(int64_t id) {
+    return id > 0 ? id & LOCAL_ID_MASK : id;
+}
+
+inline int64_t MakeShardedId(int shard, int64_t localId) {
+    return (static_cast<int64_t>(shard) << SHARD_ID_BITS) | localId;
+}
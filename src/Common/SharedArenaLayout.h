@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+// Layout of the shared-memory segment mem-mgr exports with --shm.
+// The segment holds a header, a table of block slots and then the arena:
+//
+//   [SharedArenaHeader][SharedBlockSlot x slotCount][arena bytes]
+//
+// Each slot describes one block and carries a seqlock word. Writers (the
+// server or a client) take the slot by moving seq from even to odd and
+// release it by bumping it to the next even value. Readers copy the block
+// optimistically and retry when seq changed under them.
+
+static constexpr uint64_t SHARED_ARENA_MAGIC = 0x4d504f494e545253ULL;
+static constexpr uint32_t SHARED_ARENA_VERSION = 2;
+
+struct SharedBlockSlot {
+    std::atomic<uint32_t> seq;
+    std::atomic<int64_t> id;      // Block id, 0 while the slot is unused
+    std::atomic<uint64_t> offset; // Offset of the block inside the arena
+    std::atomic<uint64_t> size;   // Size of the block in bytes
+};
+
+struct SharedArenaHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint64_t arenaOffset; // Start of the arena from the start of the segment
+    uint64_t arenaSize;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "Shared slots need lock-free atomics to work across processes");
+
+inline size_t SharedArenaOffset(uint32_t slotCount) {
+    size_t tableEnd = sizeof(SharedArenaHeader) + slotCount * sizeof(SharedBlockSlot);
+    return (tableEnd + 63) & ~size_t(63); // Keep the arena cache-line aligned
+}
+
+inline SharedBlockSlot* SharedSlots(void* segment) {
+    return reinterpret_cast<SharedBlockSlot*>(static_cast<char*>(segment) + sizeof(SharedArenaHeader));
+}
+
+// Take the slot for writing
+inline void LockSharedSlot(SharedBlockSlot& slot) {
+    uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    for (;;) {
+        if ((seq & 1) == 0 &&
+            slot.seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+            return;
+        }
+        std::this_thread::yield();
+        seq = slot.seq.load(std::memory_order_relaxed);
+    }
+}
+
+inline void UnlockSharedSlot(SharedBlockSlot& slot) {
+    slot.seq.fetch_add(1, std::memory_order_release);
+}
+
+// Run copy(offset, size) on a consistent view of the slot describing id.
+// Returns false when the slot no longer holds that block.
+template <typename CopyFn>
+bool ReadSharedSlot(const SharedBlockSlot& slot, int64_t id, CopyFn&& copy) {
+    for (;;) {
+        uint32_t before = slot.seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        
+        if (slot.id.load(std::memory_order_relaxed) != id) {
+            return false;
+        }
+        bool copied = copy(slot.offset.load(std::memory_order_relaxed), slot.size.load(std::memory_order_relaxed));
+        
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) == before) {
+            return copied;
+        }
+    }
+}
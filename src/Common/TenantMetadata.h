@@ -0,0 +1,7 @@
+#pragma once
+
+// A mem-mgr started with --tenant name:SIZE_MB serves each named tenant from
+// its own arena, with its own lock and collector. Clients pick one by sending
+// its name under this metadata key on every call; calls without it use the
+// default arena (--memsize).
+static constexpr const char* TENANT_METADATA_KEY = "mpointers-tenant";
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <typeinfo>
+
+// Description of a stored type. Clients register it once per connection and
+// refer to it by the small id the server returns in every later Create.
+struct TypeDescriptor {
+    std::string name;   // Mangled type name
+    uint32_t size;      // sizeof, 0 when unknown
+    uint32_t alignment; // alignof, 0 when unknown
+    uint64_t hash;      // Stable hash of name, identifies the type across connections
+};
+
+// FNV-1a over the type name, stable across processes built with the same ABI
+inline uint64_t TypeNameHash(const std::string& name) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : name) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Descriptor for T, built once per type
+template <typename T>
+const TypeDescriptor& TypeDescriptorOf() {
+    static const TypeDescriptor descriptor{typeid(T).name(), sizeof(T), alignof(T), TypeNameHash(typeid(T).name())};
+    return descriptor;
+}
@@ -1,47 +1,180 @@
 #include "GRPCClient.h"
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <grpcpp/support/client_interceptor.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Regions entered by the current thread, innermost last
+static thread_local std::vector<int64_t> regionStack;
+
+// Points each server gets on the consistent hashing ring
+static const int RING_POINTS_PER_SHARD = 64;
+
+// Sends the tenant name with every call made on a channel
+class TenantInterceptor : public grpc::experimental::Interceptor {
+public:
+    explicit TenantInterceptor(const std::string& tenant) : tenant(tenant) {}
+    
+    void Intercept(grpc::experimental::InterceptorBatchMethods* methods) override {
+        if (methods->QueryInterceptionHookPoint(grpc::experimental::InterceptionHookPoints::PRE_SEND_INITIAL_METADATA)) {
+            methods->GetSendInitialMetadata()->insert({TENANT_METADATA_KEY, tenant});
+        }
+        methods->Proceed();
+    }
+    
+private:
+    std::string tenant;
+};
+
+class TenantInterceptorFactory : public grpc::experimental::ClientInterceptorFactoryInterface {
+public:
+    explicit TenantInterceptorFactory(const std::string& tenant) : tenant(tenant) {}
+    
+    grpc::experimental::Interceptor* CreateClientInterceptor(grpc::experimental::ClientRpcInfo* info) override {
+        return new TenantInterceptor(tenant);
+    }
+    
+private:
+    std::string tenant;
+};
 
 GRPCClient& GRPCClient::getInstance() {
     static GRPCClient instance;
     return instance;
 }
 
-GRPCClient::GRPCClient() : connected(false) {}
+GRPCClient::GRPCClient()
+    : poolSize(1), selection(ChannelSelection::RoundRobin), shardSelection(ShardSelection::LeastLoaded),
+      nextChannel(0), nextShard(0), connected(false), rpcCount(0), useSharedMemory(true), regionBlockCount(0) {}
 
 GRPCClient::~GRPCClient() {
     Disconnect();
 }
 
 bool GRPCClient::Connect(const std::string& server_address) {
+    std::vector<std::string> addresses;
+    size_t start = 0;
+    while (start <= server_address.size()) {
+        size_t comma = server_address.find(',', start);
+        if (comma == std::string::npos) {
+            comma = server_address.size();
+        }
+        if (comma > start) {
+            addresses.push_back(server_address.substr(start, comma - start));
+        }
+        start = comma + 1;
+    }
+    return Connect(addresses);
+}
+
+bool GRPCClient::Connect(const std::vector<std::string>& serverAddresses) {
+    std::unique_lock<std::shared_mutex> lock(connectionMutex);
+    
     if (connected) {
         return true; // Already connected
     }
     
-    channel_ = grpc::CreateChannel(server_address, grpc::InsecureChannelCredentials());
-    stub_ = mpointers::MemoryManager::NewStub(channel_);
-    
-    // Try a simple ping to check connection
-    grpc::ClientContext context;
-    mpointers::RefCountRequest request;
-    mpointers::RefCountResponse response;
-    request.set_id(-1); // Invalid ID for a ping
+    if (serverAddresses.empty() || serverAddresses.size() > MAX_SHARDS) {
+        std::cerr << "Expected between 1 and " << MAX_SHARDS << " Memory Manager addresses" << std::endl;
+        return false;
+    }
     
-    grpc::Status status = stub_->IncreaseRefCount(&context, request, &response);
-    connected = status.error_code() != grpc::StatusCode::UNAVAILABLE;
+    shards.clear();
+    for (const std::string& address : serverAddresses) {
+        auto shard = std::make_unique<Shard>();
+        shard->index = static_cast<int>(shards.size());
+        shard->address = address;
+        shard->freeBytes = std::numeric_limits<int64_t>::max(); // Unknown until its first Create
+        
+        // Give every channel its own subchannel pool and a distinct argument set,
+        // otherwise gRPC would share a single TCP connection between them
+        for (size_t i = 0; i < poolSize; ++i) {
+            grpc::ChannelArguments args;
+            args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+            args.SetInt("mpointers.channel_index", static_cast<int>(i));
+            
+            Connection connection;
+            if (tenant.empty()) {
+                connection.channel = grpc::CreateCustomChannel(address, grpc::InsecureChannelCredentials(), args);
+            } else {
+                std::vector<std::unique_ptr<grpc::experimental::ClientInterceptorFactoryInterface>> interceptors;
+                interceptors.push_back(std::make_unique<TenantInterceptorFactory>(tenant));
+                connection.channel = grpc::experimental::CreateCustomChannelWithInterceptors(
+                    address, grpc::InsecureChannelCredentials(), args, std::move(interceptors));
+            }
+            connection.stub = mpointers::MemoryManager::NewStub(connection.channel);
+            shard->connections.push_back(std::move(connection));
+        }
+        
+        // Try a simple ping to check connection
+        grpc::ClientContext context;
+        mpointers::RefCountRequest request;
+        mpointers::RefCountResponse response;
+        request.set_id(-1); // Invalid ID for a ping
+        
+        // A server without the requested tenant answers NOT_FOUND
+        grpc::Status status = shard->connections.front().stub->IncreaseRefCount(&context, request, &response);
+        if (status.error_code() == grpc::StatusCode::UNAVAILABLE || status.error_code() == grpc::StatusCode::NOT_FOUND) {
+            std::cerr << "Failed to connect to Memory Manager at " << address << std::endl;
+            std::cerr << "Error: " << status.error_message() << std::endl;
+            for (auto& other : shards) {
+                UnmapSharedArena(*other);
+            }
+            shards.clear();
+            return false;
+        }
+        
+        // Start connecting the remaining channels in the background
+        for (auto& connection : shard->connections) {
+            connection.channel->GetState(true);
+        }
+        if (useSharedMemory) {
+            MapSharedArena(*shard);
+        }
+        std::cout << "Connected to Memory Manager at " << address
+                  << " (" << shard->connections.size() << " channel(s))" << std::endl;
+        shards.push_back(std::move(shard));
+    }
     
-    if (!connected) {
-        std::cerr << "Failed to connect to Memory Manager at " << server_address << std::endl;
-        std::cerr << "Error: " << status.error_message() << std::endl;
-    } else {
-        std::cout << "Connected to Memory Manager at " << server_address << std::endl;
+    // Every server owns many small arcs of the ring, so adding one moves
+    // only a share of the threads to it
+    ring.clear();
+    for (auto& shard : shards) {
+        for (int point = 0; point < RING_POINTS_PER_SHARD; ++point) {
+            ring.emplace_back(std::hash<std::string>()(shard->address + "#" + std::to_string(point)), shard.get());
+        }
     }
+    std::sort(ring.begin(), ring.end(),
+        [](const std::pair<size_t, Shard*>& a, const std::pair<size_t, Shard*>& b) {
+            return a.first < b.first;
+        });
     
-    return connected;
+    connected = true;
+    return true;
 }
 
 void GRPCClient::Disconnect() {
-    stub_.reset();
-    channel_.reset();
+    std::unique_lock<std::shared_mutex> lock(connectionMutex);
+    for (auto& shard : shards) {
+        UnmapSharedArena(*shard);
+    }
+    {
+        std::lock_guard<std::mutex> cacheLock(slotCacheMutex);
+        slotCache.clear();
+    }
+    {
+        // Regions belong to the servers we were talking to
+        std::lock_guard<std::mutex> regionLock(regionMutex);
+        regionBlocks.clear();
+        regionBlockCount = 0;
+    }
+    ring.clear();
+    shards.clear();
     connected = false;
 }
 
@@ -49,48 +182,283 @@ bool GRPCClient::IsConnected() const {
     return connected;
 }
 
-int GRPCClient::Create(size_t size, const std::string& type) {
+void GRPCClient::SetPoolSize(size_t size) {
+    std::unique_lock<std::shared_mutex> lock(connectionMutex);
+    poolSize = std::max<size_t>(1, size);
+}
+
+void GRPCClient::SetTenant(const std::string& name) {
+    std::unique_lock<std::shared_mutex> lock(connectionMutex);
+    tenant = name;
+}
+
+void GRPCClient::SetChannelSelection(ChannelSelection newSelection) {
+    std::unique_lock<std::shared_mutex> lock(connectionMutex);
+    selection = newSelection;
+}
+
+void GRPCClient::SetSharedMemory(bool enabled) {
+    std::unique_lock<std::shared_mutex> lock(connectionMutex);
+    useSharedMemory = enabled;
+}
+
+bool GRPCClient::IsSharedMemoryMapped() const {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
+    return !shards.empty() && std::all_of(shards.begin(), shards.end(),
+        [](const std::unique_ptr<Shard>& shard) { return shard->sharedSegment != nullptr; });
+}
+
+size_t GRPCClient::GetPoolSize() const {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
+    return connected ? shards.front()->connections.size() : poolSize;
+}
+
+size_t GRPCClient::GetShardCount() const {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
+    return shards.size();
+}
+
+void GRPCClient::SetShardSelection(ShardSelection newSelection) {
+    std::unique_lock<std::shared_mutex> lock(connectionMutex);
+    shardSelection = newSelection;
+}
+
+mpointers::MemoryManager::Stub* GRPCClient::PickStub(Shard& shard) {
+    std::vector<Connection>& connections = shard.connections;
+    if (selection == ChannelSelection::ThreadAffinity) {
+        // Threads are spread over the pool in the order they first call in
+        thread_local size_t threadChannel = nextChannel++;
+        return connections[threadChannel % connections.size()].stub.get();
+    }
+    return connections[nextChannel++ % connections.size()].stub.get();
+}
+
+GRPCClient::Shard* GRPCClient::FindShard(int64_t id) {
+    if (shards.size() == 1) {
+        return shards.front().get();
+    }
+    int index = ShardOfId(id);
+    if (index >= static_cast<int>(shards.size())) {
+        std::cerr << "Id " << id << " does not belong to any connected Memory Manager" << std::endl;
+        return nullptr;
+    }
+    return shards[index].get();
+}
+
+int64_t GRPCClient::LocalId(int64_t id) const {
+    return shards.size() == 1 ? id : LocalIdOf(id);
+}
+
+int64_t GRPCClient::GlobalId(const Shard& shard, int64_t localId) const {
+    if (shards.size() == 1) {
+        return localId;
+    }
+    if (localId > LOCAL_ID_MASK) {
+        std::cerr << "Memory Manager at " << shard.address << " ran out of shardable ids" << std::endl;
+        return -1;
+    }
+    return MakeShardedId(shard.index, localId);
+}
+
+std::vector<GRPCClient::Shard*> GRPCClient::PlacementOrder(size_t size) {
+    std::vector<Shard*> order;
+    
+    if (shardSelection == ShardSelection::ConsistentHash) {
+        // Walk the ring clockwise from the thread's point, each server once
+        thread_local size_t threadPoint = [] {
+            // Thread ids hash to nearby values, spread them over the ring
+            uint64_t point = std::hash<std::thread::id>()(std::this_thread::get_id());
+            point ^= point >> 33;
+            point *= 0xff51afd7ed558ccdULL;
+            point ^= point >> 33;
+            return static_cast<size_t>(point);
+        }();
+        auto it = std::lower_bound(ring.begin(), ring.end(), std::make_pair(threadPoint, static_cast<Shard*>(nullptr)),
+            [](const std::pair<size_t, Shard*>& a, const std::pair<size_t, Shard*>& b) {
+                return a.first < b.first;
+            });
+        for (size_t step = 0; step < ring.size() && order.size() < shards.size(); ++step, ++it) {
+            if (it == ring.end()) {
+                it = ring.begin();
+            }
+            if (std::find(order.begin(), order.end(), it->second) == order.end()) {
+                order.push_back(it->second);
+            }
+        }
+        return order;
+    }
+    
+    // Most free memory first, ties go round-robin so equal servers alternate
+    size_t first = nextShard++;
+    for (size_t i = 0; i < shards.size(); ++i) {
+        order.push_back(shards[(first + i) % shards.size()].get());
+    }
+    std::stable_sort(order.begin(), order.end(), [](const Shard* a, const Shard* b) {
+        return a->freeBytes.load() > b->freeBytes.load();
+    });
+    // Count the block against the server right away so concurrent Creates spread out
+    order.front()->freeBytes -= static_cast<int64_t>(size);
+    return order;
+}
+
+uint64_t GRPCClient::GetRpcCount() const {
+    return rpcCount.load();
+}
+
+void GRPCClient::ResetRpcCount() {
+    rpcCount.store(0);
+}
+
+int64_t GRPCClient::Create(size_t size, const TypeDescriptor& type) {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
     if (!connected) {
         std::cerr << "Not connected to Memory Manager" << std::endl;
         return -1;
     }
     
-    grpc::ClientContext context;
+    int64_t region = regionStack.empty() ? 0 : regionStack.back();
+    
     mpointers::CreateRequest request;
-    mpointers::CreateResponse response;
+    request.set_size(size);
+    request.set_region(region);
+    int64_t id = SendCreate(request, &type);
     
+    if (id != -1 && region != 0) {
+        std::lock_guard<std::mutex> regionLock(regionMutex);
+        regionBlocks[id] = region;
+        regionBlockCount = regionBlocks.size();
+    }
+    return id;
+}
+
+int64_t GRPCClient::Create(size_t size, const std::string& type) {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
+    if (!connected) {
+        std::cerr << "Not connected to Memory Manager" << std::endl;
+        return -1;
+    }
+    
+    mpointers::CreateRequest request;
     request.set_size(size);
     request.set_type(type);
+    return SendCreate(request, nullptr);
+}
+
+int64_t GRPCClient::SendCreate(mpointers::CreateRequest& request, const TypeDescriptor* type) {
+    // Blocks of a region live on the region's server, others go where the
+    // placement policy says and move on to the next server when one is full
+    std::vector<Shard*> order;
+    int64_t region = request.region();
+    if (region != 0) {
+        Shard* shard = FindShard(region);
+        if (!shard) {
+            return -1;
+        }
+        order.push_back(shard);
+        request.set_region(LocalId(region));
+    } else {
+        order = PlacementOrder(request.size());
+    }
     
-    grpc::Status status = stub_->Create(&context, request, &response);
+    std::string error;
+    for (Shard* shard : order) {
+        if (type) {
+            int typeId = LookupTypeId(*shard, *type);
+            if (typeId == -1) {
+                return -1;
+            }
+            request.set_type_id(typeId);
+        }
+        
+        grpc::ClientContext context;
+        mpointers::CreateResponse response;
+        
+        rpcCount++;
+        grpc::Status status = PickStub(*shard)->Create(&context, request, &response);
+        
+        if (!status.ok()) {
+            error = "Error creating memory block: " + status.error_message();
+            continue;
+        }
+        
+        shard->freeBytes = response.free_bytes();
+        if (!response.success()) {
+            error = "Failed to create memory block: " + response.error_message();
+            continue;
+        }
+        
+        int64_t id = GlobalId(*shard, response.id());
+        if (id != -1 && shard->sharedSegment) {
+            RememberSlot(id, response.slot());
+        }
+        return id;
+    }
+    
+    std::cerr << error << std::endl;
+    return -1;
+}
+
+int GRPCClient::LookupTypeId(Shard& shard, const TypeDescriptor& type) {
+    {
+        std::lock_guard<std::mutex> cacheLock(typeCacheMutex);
+        auto it = shard.typeCache.find(type.hash);
+        if (it != shard.typeCache.end()) {
+            return it->second;
+        }
+    }
+    
+    grpc::ClientContext context;
+    mpointers::RegisterTypeRequest request;
+    mpointers::RegisterTypeResponse response;
+    
+    request.set_name(type.name);
+    request.set_size(type.size);
+    request.set_alignment(type.alignment);
+    request.set_hash(type.hash);
+    
+    rpcCount++;
+    grpc::Status status = PickStub(shard)->RegisterType(&context, request, &response);
     
     if (!status.ok()) {
-        std::cerr << "Error creating memory block: " << status.error_message() << std::endl;
+        std::cerr << "Error registering type: " << status.error_message() << std::endl;
         return -1;
     }
     
     if (!response.success()) {
-        std::cerr << "Failed to create memory block: " << response.error_message() << std::endl;
+        std::cerr << "Failed to register type: " << response.error_message() << std::endl;
         return -1;
     }
     
-    return response.id();
+    std::lock_guard<std::mutex> cacheLock(typeCacheMutex);
+    shard.typeCache[type.hash] = response.type_id();
+    return response.type_id();
 }
 
-bool GRPCClient::Set(int id, const void* value, size_t valueSize) {
+bool GRPCClient::Set(int64_t id, const void* value, size_t valueSize) {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
     if (!connected) {
         std::cerr << "Not connected to Memory Manager" << std::endl;
         return false;
     }
     
+    Shard* shard = FindShard(id);
+    if (!shard) {
+        return false;
+    }
+    
+    if (WriteShared(*shard, id, 0, value, valueSize)) {
+        return true;
+    }
+    
     grpc::ClientContext context;
     mpointers::SetRequest request;
     mpointers::SetResponse response;
     
-    request.set_id(id);
+    request.set_id(LocalId(id));
     request.set_value(value, valueSize);
     
-    grpc::Status status = stub_->Set(&context, request, &response);
+    rpcCount++;
+    grpc::Status status = PickStub(*shard)->Set(&context, request, &response);
     
     if (!status.ok()) {
         std::cerr << "Error setting value: " << status.error_message() << std::endl;
@@ -105,19 +473,30 @@ bool GRPCClient::Set(int id, const void* value, size_t valueSize) {
     return true;
 }
 
-bool GRPCClient::Get(int id, void* value, size_t maxSize, size_t& actualSize) {
+bool GRPCClient::Get(int64_t id, void* value, size_t maxSize, size_t& actualSize) {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
     if (!connected) {
         std::cerr << "Not connected to Memory Manager" << std::endl;
         return false;
     }
     
+    Shard* shard = FindShard(id);
+    if (!shard) {
+        return false;
+    }
+    
+    if (ReadShared(*shard, id, 0, value, maxSize, actualSize)) {
+        return true;
+    }
+    
     grpc::ClientContext context;
     mpointers::GetRequest request;
     mpointers::GetResponse response;
     
-    request.set_id(id);
+    request.set_id(LocalId(id));
     
-    grpc::Status status = stub_->Get(&context, request, &response);
+    rpcCount++;
+    grpc::Status status = PickStub(*shard)->Get(&context, request, &response);
     
     if (!status.ok()) {
         std::cerr << "Error getting value: " << status.error_message() << std::endl;
@@ -136,19 +515,336 @@ bool GRPCClient::Get(int id, void* value, size_t maxSize, size_t& actualSize) {
     return true;
 }
 
-bool GRPCClient::IncreaseRefCount(int id) {
+bool GRPCClient::GetRange(int64_t id, size_t offset, void* value, size_t length, size_t& actualSize) {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
+    if (!connected) {
+        std::cerr << "Not connected to Memory Manager" << std::endl;
+        return false;
+    }
+    
+    Shard* shard = FindShard(id);
+    if (!shard) {
+        return false;
+    }
+    
+    if (ReadShared(*shard, id, offset, value, length, actualSize)) {
+        return true;
+    }
+    
+    grpc::ClientContext context;
+    mpointers::GetRangeRequest request;
+    mpointers::GetResponse response;
+    
+    request.set_id(LocalId(id));
+    request.set_offset(offset);
+    request.set_length(length);
+    
+    rpcCount++;
+    grpc::Status status = PickStub(*shard)->GetRange(&context, request, &response);
+    
+    if (!status.ok()) {
+        std::cerr << "Error getting range: " << status.error_message() << std::endl;
+        return false;
+    }
+    
+    if (!response.success()) {
+        std::cerr << "Failed to get range: " << response.error_message() << std::endl;
+        return false;
+    }
+    
+    const std::string& data = response.value();
+    actualSize = std::min(length, data.size());
+    memcpy(value, data.data(), actualSize);
+    
+    return true;
+}
+
+bool GRPCClient::SetRange(int64_t id, size_t offset, const void* value, size_t valueSize) {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
+    if (!connected) {
+        std::cerr << "Not connected to Memory Manager" << std::endl;
+        return false;
+    }
+    
+    Shard* shard = FindShard(id);
+    if (!shard) {
+        return false;
+    }
+    
+    if (WriteShared(*shard, id, offset, value, valueSize)) {
+        return true;
+    }
+    
+    grpc::ClientContext context;
+    mpointers::SetRangeRequest request;
+    mpointers::SetResponse response;
+    
+    request.set_id(LocalId(id));
+    request.set_offset(offset);
+    request.set_value(value, valueSize);
+    
+    rpcCount++;
+    grpc::Status status = PickStub(*shard)->SetRange(&context, request, &response);
+    
+    if (!status.ok()) {
+        std::cerr << "Error setting range: " << status.error_message() << std::endl;
+        return false;
+    }
+    
+    if (!response.success()) {
+        std::cerr << "Failed to set range: " << response.error_message() << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+bool GRPCClient::GetBatch(const std::vector<int64_t>& ids, std::vector<std::string>& values) {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
+    if (!connected) {
+        std::cerr << "Not connected to Memory Manager" << std::endl;
+        return false;
+    }
+    
+    // Serve the whole batch from the shared arenas when every block is mapped
+    bool anyMapped = std::any_of(shards.begin(), shards.end(),
+        [](const std::unique_ptr<Shard>& shard) { return shard->sharedSegment != nullptr; });
+    if (anyMapped) {
+        std::vector<std::string> sharedValues(ids.size());
+        size_t mapped = 0;
+        while (mapped < ids.size() && ReadSharedBlock(ids[mapped], sharedValues[mapped])) {
+            mapped++;
+        }
+        if (mapped == ids.size()) {
+            values = std::move(sharedValues);
+            return true;
+        }
+    }
+    
+    // One RPC per server that owns some of the blocks
+    std::vector<std::vector<size_t>> positions(shards.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        Shard* shard = FindShard(ids[i]);
+        if (!shard) {
+            return false;
+        }
+        positions[shard->index].push_back(i);
+    }
+    
+    values.assign(ids.size(), std::string());
+    for (auto& shard : shards) {
+        const std::vector<size_t>& owned = positions[shard->index];
+        if (owned.empty()) {
+            continue;
+        }
+        
+        grpc::ClientContext context;
+        mpointers::GetBatchRequest request;
+        mpointers::GetBatchResponse response;
+        
+        for (size_t position : owned) {
+            request.add_ids(LocalId(ids[position]));
+        }
+        
+        rpcCount++;
+        grpc::Status status = PickStub(*shard)->GetBatch(&context, request, &response);
+        
+        if (!status.ok()) {
+            std::cerr << "Error getting batch: " << status.error_message() << std::endl;
+            return false;
+        }
+        
+        if (!response.success() || response.values_size() != static_cast<int>(owned.size())) {
+            std::cerr << "Failed to get batch: " << response.error_message() << std::endl;
+            return false;
+        }
+        
+        for (size_t i = 0; i < owned.size(); ++i) {
+            values[owned[i]] = std::move(*response.mutable_values(static_cast<int>(i)));
+        }
+    }
+    return true;
+}
+
+bool GRPCClient::Traverse(int64_t startId, size_t nextOffset, int skip, int maxCount,
+                          std::vector<std::string>& values, int64_t& nextId) {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
+    if (!connected) {
+        std::cerr << "Not connected to Memory Manager" << std::endl;
+        return false;
+    }
+    
+    // Each server walks the chain until it reaches a node on another server,
+    // which continues from there
+    values.clear();
+    nextId = startId;
+    while (true) {
+        Shard* shard = FindShard(nextId);
+        if (!shard) {
+            return false;
+        }
+        
+        grpc::ClientContext context;
+        mpointers::TraverseRequest request;
+        mpointers::TraverseResponse response;
+        
+        request.set_start_id(nextId);
+        request.set_next_offset(nextOffset);
+        request.set_skip(skip);
+        request.set_max_count(maxCount - static_cast<int>(values.size()));
+        request.set_sharded(shards.size() > 1);
+        request.set_shard(shard->index);
+        
+        rpcCount++;
+        grpc::Status status = PickStub(*shard)->Traverse(&context, request, &response);
+        
+        if (!status.ok()) {
+            std::cerr << "Error traversing: " << status.error_message() << std::endl;
+            return false;
+        }
+        
+        if (!response.success()) {
+            std::cerr << "Failed to traverse: " << response.error_message() << std::endl;
+            return false;
+        }
+        
+        for (auto& value : *response.mutable_values()) {
+            values.push_back(std::move(value));
+        }
+        skip -= response.skipped();
+        nextId = response.next_id();
+        
+        // Done at the end of the chain, with enough nodes, or when the server
+        // stopped on its own (response size limit)
+        if (nextId == -1 || static_cast<int>(values.size()) >= maxCount ||
+            shards.size() == 1 || FindShard(nextId) == shard) {
+            return true;
+        }
+    }
+}
+
+bool GRPCClient::Resize(int64_t id, size_t newSize) {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
+    if (!connected) {
+        std::cerr << "Not connected to Memory Manager" << std::endl;
+        return false;
+    }
+    
+    Shard* shard = FindShard(id);
+    if (!shard) {
+        return false;
+    }
+    
+    grpc::ClientContext context;
+    mpointers::ResizeRequest request;
+    mpointers::ResizeResponse response;
+    
+    request.set_id(LocalId(id));
+    request.set_new_size(newSize);
+    
+    rpcCount++;
+    grpc::Status status = PickStub(*shard)->Resize(&context, request, &response);
+    
+    if (!status.ok()) {
+        std::cerr << "Error resizing: " << status.error_message() << std::endl;
+        return false;
+    }
+    
+    if (!response.success()) {
+        std::cerr << "Failed to resize: " << response.error_message() << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+bool GRPCClient::FetchAdd(int64_t id, size_t offset, size_t width, int64_t delta, int64_t& previous) {
+    return Atomic(id, offset, width, BlockAtomicOp::FetchAdd, delta, 0, previous);
+}
+
+bool GRPCClient::CompareExchange(int64_t id, size_t offset, size_t width, int64_t expected, int64_t desired,
+                                 int64_t& previous) {
+    return Atomic(id, offset, width, BlockAtomicOp::CompareExchange, desired, expected, previous);
+}
+
+bool GRPCClient::Exchange(int64_t id, size_t offset, size_t width, int64_t value, int64_t& previous) {
+    return Atomic(id, offset, width, BlockAtomicOp::Exchange, value, 0, previous);
+}
+
+bool GRPCClient::Atomic(int64_t id, size_t offset, size_t width, BlockAtomicOp op,
+                        int64_t operand, int64_t expected, int64_t& previous) {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
     if (!connected) {
         std::cerr << "Not connected to Memory Manager" << std::endl;
         return false;
     }
     
+    Shard* shard = FindShard(id);
+    if (!shard) {
+        return false;
+    }
+    
+    if (AtomicShared(*shard, id, offset, width, op, operand, expected, previous)) {
+        return true;
+    }
+    
+    grpc::ClientContext context;
+    mpointers::AtomicRequest request;
+    mpointers::AtomicResponse response;
+    
+    request.set_id(LocalId(id));
+    request.set_offset(offset);
+    request.set_width(width);
+    switch (op) {
+        case BlockAtomicOp::FetchAdd: request.set_op(mpointers::FETCH_ADD); break;
+        case BlockAtomicOp::CompareExchange: request.set_op(mpointers::COMPARE_EXCHANGE); break;
+        case BlockAtomicOp::Exchange: request.set_op(mpointers::EXCHANGE); break;
+    }
+    request.set_operand(operand);
+    request.set_expected(expected);
+    
+    rpcCount++;
+    grpc::Status status = PickStub(*shard)->Atomic(&context, request, &response);
+    
+    if (!status.ok()) {
+        std::cerr << "Error applying atomic operation: " << status.error_message() << std::endl;
+        return false;
+    }
+    
+    if (!response.success()) {
+        std::cerr << "Failed to apply atomic operation: " << response.error_message() << std::endl;
+        return false;
+    }
+    
+    previous = response.previous();
+    return true;
+}
+
+bool GRPCClient::IncreaseRefCount(int64_t id) {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
+    if (!connected) {
+        std::cerr << "Not connected to Memory Manager" << std::endl;
+        return false;
+    }
+    
+    Shard* shard = FindShard(id);
+    if (!shard) {
+        return false;
+    }
+    
+    // Region blocks are not refcounted, their region frees them
+    if (IsRegionBlock(id)) {
+        return true;
+    }
+    
     grpc::ClientContext context;
     mpointers::RefCountRequest request;
     mpointers::RefCountResponse response;
     
-    request.set_id(id);
+    request.set_id(LocalId(id));
     
-    grpc::Status status = stub_->IncreaseRefCount(&context, request, &response);
+    rpcCount++;
+    grpc::Status status = PickStub(*shard)->IncreaseRefCount(&context, request, &response);
     
     if (!status.ok()) {
         std::cerr << "Error increasing reference count: " << status.error_message() << std::endl;
@@ -163,19 +859,31 @@ bool GRPCClient::IncreaseRefCount(int id) {
     return true;
 }
 
-bool GRPCClient::DecreaseRefCount(int id) {
+bool GRPCClient::DecreaseRefCount(int64_t id) {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
     if (!connected) {
         std::cerr << "Not connected to Memory Manager" << std::endl;
         return false;
     }
     
+    Shard* shard = FindShard(id);
+    if (!shard) {
+        return false;
+    }
+    
+    // Region blocks are not refcounted, their region frees them
+    if (IsRegionBlock(id)) {
+        return true;
+    }
+    
     grpc::ClientContext context;
     mpointers::RefCountRequest request;
     mpointers::RefCountResponse response;
     
-    request.set_id(id);
+    request.set_id(LocalId(id));
     
-    grpc::Status status = stub_->DecreaseRefCount(&context, request, &response);
+    rpcCount++;
+    grpc::Status status = PickStub(*shard)->DecreaseRefCount(&context, request, &response);
     
     if (!status.ok()) {
         std::cerr << "Error decreasing reference count: " << status.error_message() << std::endl;
@@ -188,4 +896,343 @@ bool GRPCClient::DecreaseRefCount(int id) {
     }
     
     return true;
-}
\ No newline at end of file
+}
+
+int64_t GRPCClient::CreateRegion() {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
+    if (!connected) {
+        std::cerr << "Not connected to Memory Manager" << std::endl;
+        return -1;
+    }
+    
+    // A region lives on one server, picked like the server of a block
+    Shard* shard = PlacementOrder(0).front();
+    
+    grpc::ClientContext context;
+    mpointers::CreateRegionRequest request;
+    mpointers::CreateRegionResponse response;
+    
+    rpcCount++;
+    grpc::Status status = PickStub(*shard)->CreateRegion(&context, request, &response);
+    
+    if (!status.ok()) {
+        std::cerr << "Error creating region: " << status.error_message() << std::endl;
+        return -1;
+    }
+    
+    if (!response.success()) {
+        std::cerr << "Failed to create region: " << response.error_message() << std::endl;
+        return -1;
+    }
+    
+    return GlobalId(*shard, response.region_id());
+}
+
+bool GRPCClient::ReleaseRegion(int64_t regionId) {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
+    if (!connected) {
+        std::cerr << "Not connected to Memory Manager" << std::endl;
+        return false;
+    }
+    
+    Shard* shard = FindShard(regionId);
+    if (!shard) {
+        return false;
+    }
+    
+    grpc::ClientContext context;
+    mpointers::ReleaseRegionRequest request;
+    mpointers::ReleaseRegionResponse response;
+    
+    request.set_region_id(LocalId(regionId));
+    
+    rpcCount++;
+    grpc::Status status = PickStub(*shard)->ReleaseRegion(&context, request, &response);
+    
+    // Forget the region's blocks whatever the outcome, they are unusable either way
+    {
+        std::lock_guard<std::mutex> regionLock(regionMutex);
+        std::lock_guard<std::mutex> cacheLock(slotCacheMutex);
+        for (auto it = regionBlocks.begin(); it != regionBlocks.end();) {
+            if (it->second == regionId) {
+                slotCache.erase(it->first);
+                it = regionBlocks.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        regionBlockCount = regionBlocks.size();
+    }
+    
+    if (!status.ok()) {
+        std::cerr << "Error releasing region: " << status.error_message() << std::endl;
+        return false;
+    }
+    
+    if (!response.success()) {
+        std::cerr << "Failed to release region: " << response.error_message() << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+void GRPCClient::EnterRegion(int64_t regionId) {
+    regionStack.push_back(regionId);
+}
+
+void GRPCClient::LeaveRegion(int64_t regionId) {
+    auto it = std::find(regionStack.rbegin(), regionStack.rend(), regionId);
+    if (it != regionStack.rend()) {
+        regionStack.erase(std::next(it).base());
+    }
+}
+
+bool GRPCClient::IsRegionBlock(int64_t id) {
+    if (regionBlockCount == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> regionLock(regionMutex);
+    return regionBlocks.count(id) > 0;
+}
+
+long long GRPCClient::Snapshot(const std::string& path) {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
+    if (!connected) {
+        std::cerr << "Not connected to Memory Manager" << std::endl;
+        return -1;
+    }
+    
+    long long total = 0;
+    for (auto& shard : shards) {
+        grpc::ClientContext context;
+        mpointers::SnapshotRequest request;
+        mpointers::SnapshotResponse response;
+        
+        request.set_path(shards.size() == 1 ? path : path + "." + std::to_string(shard->index));
+        
+        rpcCount++;
+        grpc::Status status = PickStub(*shard)->Snapshot(&context, request, &response);
+        
+        if (!status.ok()) {
+            std::cerr << "Error writing snapshot: " << status.error_message() << std::endl;
+            return -1;
+        }
+        
+        if (!response.success()) {
+            std::cerr << "Failed to write snapshot: " << response.error_message() << std::endl;
+            return -1;
+        }
+        
+        total += response.bytes_written();
+    }
+    
+    return total;
+}
+
+bool GRPCClient::Promote() {
+    std::shared_lock<std::shared_mutex> lock(connectionMutex);
+    if (!connected) {
+        std::cerr << "Not connected to Memory Manager" << std::endl;
+        return false;
+    }
+    
+    for (auto& shard : shards) {
+        grpc::ClientContext context;
+        mpointers::PromoteRequest request;
+        mpointers::PromoteResponse response;
+        
+        rpcCount++;
+        grpc::Status status = PickStub(*shard)->Promote(&context, request, &response);
+        
+        if (!status.ok()) {
+            std::cerr << "Error promoting " << shard->address << ": " << status.error_message() << std::endl;
+            return false;
+        }
+        
+        if (!response.success()) {
+            std::cerr << "Failed to promote " << shard->address << ": " << response.error_message() << std::endl;
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+void GRPCClient::MapSharedArena(Shard& shard) {
+    grpc::ClientContext context;
+    mpointers::ArenaInfoRequest request;
+    mpointers::ArenaInfoResponse response;
+    
+    rpcCount++;
+    grpc::Status status = PickStub(shard)->GetArenaInfo(&context, request, &response);
+    if (!status.ok() || response.shm_name().empty()) {
+        return; // Server does not export its arena, stay on gRPC
+    }
+    
+    // Only works when the server runs on this host
+    int fd = shm_open(response.shm_name().c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        return;
+    }
+    void* segment = mmap(nullptr, response.segment_size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED) {
+        return;
+    }
+    
+    const SharedArenaHeader* header = static_cast<const SharedArenaHeader*>(segment);
+    if (header->magic != SHARED_ARENA_MAGIC || header->version != SHARED_ARENA_VERSION ||
+        header->arenaOffset + header->arenaSize > response.segment_size()) {
+        munmap(segment, response.segment_size());
+        return;
+    }
+    
+    shard.sharedSegment = segment;
+    shard.sharedSegmentSize = response.segment_size();
+    shard.sharedArena = static_cast<char*>(segment) + header->arenaOffset;
+    shard.sharedArenaSize = header->arenaSize;
+    shard.sharedSlots = SharedSlots(segment);
+    shard.sharedSlotCount = header->slotCount;
+    std::cout << "Mapped shared arena " << response.shm_name() << std::endl;
+}
+
+void GRPCClient::UnmapSharedArena(Shard& shard) {
+    if (shard.sharedSegment) {
+        munmap(shard.sharedSegment, shard.sharedSegmentSize);
+    }
+    shard.sharedSegment = nullptr;
+    shard.sharedArena = nullptr;
+    shard.sharedSlots = nullptr;
+    shard.sharedSlotCount = 0;
+}
+
+void GRPCClient::RememberSlot(int64_t id, int slot) {
+    std::lock_guard<std::mutex> cacheLock(slotCacheMutex);
+    slotCache[id] = slot;
+}
+
+int GRPCClient::LookupSlot(Shard& shard, int64_t id) {
+    {
+        std::lock_guard<std::mutex> cacheLock(slotCacheMutex);
+        auto it = slotCache.find(id);
+        if (it != slotCache.end()) {
+            return it->second;
+        }
+    }
+    
+    // First access to a block created elsewhere
+    grpc::ClientContext context;
+    mpointers::LocateRequest request;
+    mpointers::LocateResponse response;
+    request.set_id(LocalId(id));
+    
+    rpcCount++;
+    grpc::Status status = PickStub(shard)->Locate(&context, request, &response);
+    if (!status.ok()) {
+        return -1;
+    }
+    
+    int slot = response.success() ? response.slot() : -1;
+    RememberSlot(id, slot);
+    return slot;
+}
+
+bool GRPCClient::ReadShared(Shard& shard, int64_t id, size_t offset, void* value, size_t length, size_t& actualSize) {
+    if (!shard.sharedSegment || id <= 0) {
+        return false;
+    }
+    int slot = LookupSlot(shard, id);
+    if (slot < 0 || static_cast<uint32_t>(slot) >= shard.sharedSlotCount) {
+        return false;
+    }
+    
+    // Slots hold the server's own id
+    return ReadSharedSlot(shard.sharedSlots[slot], LocalId(id), [&](uint64_t blockOffset, uint64_t blockSize) {
+        // Values may be torn while a writer is active, check before copying
+        if (blockOffset > shard.sharedArenaSize || blockSize > shard.sharedArenaSize - blockOffset ||
+            offset > blockSize) {
+            return false; // Invalid ranges are left for the RPC path to report
+        }
+        actualSize = std::min<size_t>(length, blockSize - offset);
+        memcpy(value, shard.sharedArena + blockOffset + offset, actualSize);
+        return true;
+    });
+}
+
+bool GRPCClient::ReadSharedBlock(int64_t id, std::string& value) {
+    Shard* shard = FindShard(id);
+    if (!shard || !shard->sharedSegment || id <= 0) {
+        return false;
+    }
+    int slot = LookupSlot(*shard, id);
+    if (slot < 0 || static_cast<uint32_t>(slot) >= shard->sharedSlotCount) {
+        return false;
+    }
+    
+    return ReadSharedSlot(shard->sharedSlots[slot], LocalId(id), [&](uint64_t blockOffset, uint64_t blockSize) {
+        if (blockOffset > shard->sharedArenaSize || blockSize > shard->sharedArenaSize - blockOffset) {
+            return false;
+        }
+        value.assign(shard->sharedArena + blockOffset, blockSize);
+        return true;
+    });
+}
+
+bool GRPCClient::WriteShared(Shard& shard, int64_t id, size_t offset, const void* value, size_t valueSize) {
+    if (!shard.sharedSegment || id <= 0) {
+        return false;
+    }
+    int slot = LookupSlot(shard, id);
+    if (slot < 0 || static_cast<uint32_t>(slot) >= shard.sharedSlotCount) {
+        return false;
+    }
+    
+    SharedBlockSlot& sharedSlot = shard.sharedSlots[slot];
+    LockSharedSlot(sharedSlot);
+    uint64_t blockOffset = sharedSlot.offset.load(std::memory_order_relaxed);
+    uint64_t blockSize = sharedSlot.size.load(std::memory_order_relaxed);
+    bool sameBlock = sharedSlot.id.load(std::memory_order_relaxed) == LocalId(id);
+    bool fits = offset <= blockSize && valueSize <= blockSize - offset;
+    if (sameBlock && fits) {
+        memcpy(shard.sharedArena + blockOffset + offset, value, valueSize);
+    }
+    UnlockSharedSlot(sharedSlot);
+    
+    if (!sameBlock) {
+        // Slot was reused for another block
+        std::lock_guard<std::mutex> cacheLock(slotCacheMutex);
+        slotCache.erase(id);
+    }
+    return sameBlock && fits;
+}
+
+bool GRPCClient::AtomicShared(Shard& shard, int64_t id, size_t offset, size_t width, BlockAtomicOp op,
+                              int64_t operand, int64_t expected, int64_t& previous) {
+    if (!shard.sharedSegment || id <= 0) {
+        return false;
+    }
+    int slot = LookupSlot(shard, id);
+    if (slot < 0 || static_cast<uint32_t>(slot) >= shard.sharedSlotCount) {
+        return false;
+    }
+    
+    // Holding the slot makes the update atomic with respect to the server and other clients
+    SharedBlockSlot& sharedSlot = shard.sharedSlots[slot];
+    LockSharedSlot(sharedSlot);
+    uint64_t blockOffset = sharedSlot.offset.load(std::memory_order_relaxed);
+    uint64_t blockSize = sharedSlot.size.load(std::memory_order_relaxed);
+    bool sameBlock = sharedSlot.id.load(std::memory_order_relaxed) == LocalId(id);
+    bool valid = IsValidAtomicWord(offset, width, blockSize);
+    if (sameBlock && valid) {
+        previous = ApplyBlockAtomic(shard.sharedArena + blockOffset + offset, op, width, operand, expected);
+    }
+    UnlockSharedSlot(sharedSlot);
+    
+    if (!sameBlock) {
+        // Slot was reused for another block
+        std::lock_guard<std::mutex> cacheLock(slotCacheMutex);
+        slotCache.erase(id);
+    }
+    return sameBlock && valid;
+}
@@ -2,22 +2,109 @@
 
 #include <string>
 #include <memory>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <mutex>
+#include <unordered_map>
 #include <grpcpp/grpcpp.h>
 #include "mpointers.grpc.pb.h"
+#include "SharedArenaLayout.h"
+#include "BlockAtomics.h"
+#include "TypeDescriptor.h"
+#include "ShardedId.h"
+#include "TenantMetadata.h"
+
+// How a call picks a channel from the pool
+enum class ChannelSelection {
+    RoundRobin,     // Every call takes the next channel
+    ThreadAffinity  // Each thread sticks to one channel
+};
+
+// How Create picks a server when the client is connected to several
+enum class ShardSelection {
+    LeastLoaded,    // The server that last reported the most free memory
+    ConsistentHash  // Each thread sticks to the server its id hashes to on a ring,
+                    // so the structures a thread builds stay on one server
+};
 
 class GRPCClient {
 public:
     static GRPCClient& getInstance();
     
+    // A comma-separated list of addresses connects to several Memory Managers:
+    // Create spreads blocks over them (falling back to the others when one is
+    // full) and the returned ids route every later call to the owning server
     bool Connect(const std::string& server_address);
+    bool Connect(const std::vector<std::string>& serverAddresses);
     void Disconnect();
     bool IsConnected() const;
+    size_t GetShardCount() const;
+    void SetShardSelection(ShardSelection selection);
+    
+    // Pool configuration, applied on the next Connect
+    void SetPoolSize(size_t size);
+    // Tenant arena to use on every server (mem-mgr --tenant), empty for the default one
+    void SetTenant(const std::string& name);
+    void SetChannelSelection(ChannelSelection selection);
+    size_t GetPoolSize() const;
+    
+    // Map the server's shared arena when it exports one (default on),
+    // Get/Set then bypass gRPC for blocks that have a shared slot
+    void SetSharedMemory(bool enabled);
+    bool IsSharedMemoryMapped() const;
+    
+    // Create a block holding type, the descriptor is registered on first use
+    // per connection and later Creates only send its id
+    int64_t Create(size_t size, const TypeDescriptor& type);
+    int64_t Create(size_t size, const std::string& type);
+    bool Set(int64_t id, const void* value, size_t valueSize);
+    bool Get(int64_t id, void* value, size_t maxSize, size_t& actualSize);
+    
+    // Ranged access to part of a block, offsets are in bytes
+    bool GetRange(int64_t id, size_t offset, void* value, size_t length, size_t& actualSize);
+    bool SetRange(int64_t id, size_t offset, const void* value, size_t valueSize);
+    
+    // Fetch several whole blocks in one RPC, values come back in the order of ids
+    bool GetBatch(const std::vector<int64_t>& ids, std::vector<std::string>& values);
+    
+    // Walk a chain of blocks on the server, nextId is where to continue (-1 at the end)
+    bool Traverse(int64_t startId, size_t nextOffset, int skip, int maxCount,
+                  std::vector<std::string>& values, int64_t& nextId);
+    
+    // Change the size of a block, the id stays valid and the contents are kept
+    bool Resize(int64_t id, size_t newSize);
+    
+    // Atomic updates of the aligned 4- or 8-byte word at offset inside a block,
+    // previous receives the value the word held before the update
+    bool FetchAdd(int64_t id, size_t offset, size_t width, int64_t delta, int64_t& previous);
+    bool CompareExchange(int64_t id, size_t offset, size_t width, int64_t expected, int64_t desired, int64_t& previous);
+    bool Exchange(int64_t id, size_t offset, size_t width, int64_t value, int64_t& previous);
+    
+    bool IncreaseRefCount(int64_t id);
+    bool DecreaseRefCount(int64_t id);
+    
+    // Regions (see MScope). Blocks created by a thread while it has a region
+    // entered belong to that region: refcount calls on them send no RPC and
+    // ReleaseRegion frees all of them at once
+    int64_t CreateRegion();
+    bool ReleaseRegion(int64_t regionId);
+    void EnterRegion(int64_t regionId);
+    void LeaveRegion(int64_t regionId);
+    
+    // Ask the server to write a snapshot to path (on the server's filesystem),
+    // mem-mgr --restore path starts from it. Returns the bytes written or -1.
+    // With several servers each one writes path.<index>
+    long long Snapshot(const std::string& path);
     
-    int Create(size_t size, const std::string& type);
-    bool Set(int id, const void* value, size_t valueSize);
-    bool Get(int id, void* value, size_t maxSize, size_t& actualSize);
-    bool IncreaseRefCount(int id);
-    bool DecreaseRefCount(int id);
+    // Promote the connected follower(s) (mem-mgr --role follower) to primary
+    // after their primary is lost, so they start accepting writes
+    bool Promote();
+    
+    // Number of RPCs issued since the last reset (used by tests and benchmarks)
+    uint64_t GetRpcCount() const;
+    void ResetRpcCount();
     
 private:
     GRPCClient();
@@ -27,7 +114,78 @@ private:
     GRPCClient(const GRPCClient&) = delete;
     GRPCClient& operator=(const GRPCClient&) = delete;
     
-    std::unique_ptr<mpointers::MemoryManager::Stub> stub_;
-    std::shared_ptr<grpc::Channel> channel_;
-    bool connected;
-};
\ No newline at end of file
+    // One pooled channel, each one opens its own TCP connection
+    struct Connection {
+        std::shared_ptr<grpc::Channel> channel;
+        std::unique_ptr<mpointers::MemoryManager::Stub> stub;
+    };
+    
+    // One Memory Manager of the set, with its own channel pool and mapping
+    struct Shard {
+        int index;
+        std::string address;
+        std::vector<Connection> connections;
+        std::atomic<int64_t> freeBytes; // Last reported by the server, lowered as Creates go out
+        std::unordered_map<uint64_t, int> typeCache; // Type hash -> id on this server (typeCacheMutex)
+        
+        // Shared arena of the server when it exports one and runs on this host
+        void* sharedSegment = nullptr;
+        size_t sharedSegmentSize = 0;
+        char* sharedArena = nullptr;
+        size_t sharedArenaSize = 0;
+        SharedBlockSlot* sharedSlots = nullptr;
+        uint32_t sharedSlotCount = 0;
+    };
+    
+    // Everything below needs connectionMutex held (shared is enough)
+    mpointers::MemoryManager::Stub* PickStub(Shard& shard);
+    
+    // Owning server of a block or region id (reports ids of no connected server)
+    Shard* FindShard(int64_t id);
+    int64_t LocalId(int64_t id) const;
+    int64_t GlobalId(const Shard& shard, int64_t localId) const;
+    
+    // Servers in the order Create tries them
+    std::vector<Shard*> PlacementOrder(size_t size);
+    
+    // Type id for a descriptor on shard, registering it on a cache miss
+    int LookupTypeId(Shard& shard, const TypeDescriptor& type);
+    int64_t SendCreate(mpointers::CreateRequest& request, const TypeDescriptor* type);
+    bool IsRegionBlock(int64_t id);
+    
+    // Shared-memory data plane
+    void MapSharedArena(Shard& shard);
+    void UnmapSharedArena(Shard& shard);
+    int LookupSlot(Shard& shard, int64_t id);
+    void RememberSlot(int64_t id, int slot);
+    bool ReadShared(Shard& shard, int64_t id, size_t offset, void* value, size_t length, size_t& actualSize);
+    bool ReadSharedBlock(int64_t id, std::string& value);
+    bool WriteShared(Shard& shard, int64_t id, size_t offset, const void* value, size_t valueSize);
+    bool AtomicShared(Shard& shard, int64_t id, size_t offset, size_t width, BlockAtomicOp op,
+                      int64_t operand, int64_t expected, int64_t& previous);
+    
+    bool Atomic(int64_t id, size_t offset, size_t width, BlockAtomicOp op,
+                int64_t operand, int64_t expected, int64_t& previous);
+    
+    mutable std::shared_mutex connectionMutex;
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<std::pair<size_t, Shard*>> ring; // Consistent hashing points, sorted
+    size_t poolSize;
+    std::string tenant;
+    ChannelSelection selection;
+    ShardSelection shardSelection;
+    std::atomic<size_t> nextChannel;
+    std::atomic<size_t> nextShard;
+    std::atomic<bool> connected;
+    std::atomic<uint64_t> rpcCount;
+    
+    bool useSharedMemory;
+    std::mutex slotCacheMutex;
+    std::unordered_map<int64_t, int> slotCache; // Block id -> shared slot, -1 when it has none
+    
+    std::mutex typeCacheMutex;
+    
+    std::mutex regionMutex;
+    std::unordered_map<int64_t, int64_t> regionBlocks; // Block id -> region, for blocks of live regions
+    std::atomic<size_t> regionBlockCount;      // regionBlocks.size(), read without the lock
+};
@@ -0,0 +1,278 @@
+#pragma once
+
+#include "GRPCClient.h"
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+template <typename T>
+class MVector;
+
+// Array of T stored in one contiguous block of the Memory Manager.
+// Elements are moved as raw bytes, ranged reads and writes go out as
+// one RPC per MAX_TRANSFER_BYTES.
+template <typename T>
+class MArray {
+    static_assert(std::is_trivially_copyable<T>::value, "MArray elements must be trivially copyable");
+
+public:
+    // Largest payload sent in a single ranged RPC
+    static constexpr size_t MAX_TRANSFER_BYTES = 1024 * 1024;
+    // Elements fetched per RPC while iterating
+    static constexpr size_t CHUNK_ELEMENTS = std::max<size_t>(1, (64 * 1024) / sizeof(T));
+    
+    // Proxy returned by operator[] so reads and writes each cost one RPC
+    class Reference {
+    public:
+        operator T() const { return array->get(index); }
+        
+        Reference& operator=(const T& value) {
+            array->set(index, value);
+            return *this;
+        }
+        
+        Reference& operator=(const Reference& other) {
+            return *this = static_cast<T>(other);
+        }
+    
+    private:
+        friend class MArray<T>;
+        Reference(MArray<T>* array, size_t index) : array(array), index(index) {}
+        
+        MArray<T>* array;
+        size_t index;
+    };
+    
+    // Input iterator that fetches CHUNK_ELEMENTS elements at a time
+    class const_iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+        
+        const_iterator() : array(nullptr), index(0), chunkStart(0) {}
+        
+        reference operator*() const {
+            if (chunk.empty() || index < chunkStart || index >= chunkStart + chunk.size()) {
+                chunkStart = index;
+                chunk = array->read(index, std::min(CHUNK_ELEMENTS, array->size() - index));
+            }
+            return chunk[index - chunkStart];
+        }
+        
+        pointer operator->() const { return &**this; }
+        
+        const_iterator& operator++() {
+            ++index;
+            return *this;
+        }
+        
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++index;
+            return previous;
+        }
+        
+        bool operator==(const const_iterator& other) const { return index == other.index; }
+        bool operator!=(const const_iterator& other) const { return index != other.index; }
+    
+    private:
+        friend class MArray<T>;
+        template <typename> friend class MVector;
+        const_iterator(const MArray<T>* array, size_t index) : array(array), index(index), chunkStart(0) {}
+        
+        const MArray<T>* array;
+        size_t index;
+        mutable size_t chunkStart;
+        mutable std::vector<T> chunk;
+    };
+    
+    // Default constructor
+    MArray() : id(-1), count(0) {}
+    
+    // Create a new array of count elements (one allocation)
+    static MArray<T> New(size_t count) {
+        if (count == 0) {
+            throw std::invalid_argument("MArray size must be greater than zero");
+        }
+        
+        MArray<T> array;
+        array.id = GRPCClient::getInstance().Create(count * sizeof(T), TypeDescriptorOf<T>());
+        if (array.id == -1) {
+            throw std::runtime_error("Failed to create memory block");
+        }
+        array.count = count;
+        
+        return array;
+    }
+    
+    // Destructor
+    ~MArray() {
+        if (id != -1) {
+            GRPCClient::getInstance().DecreaseRefCount(id);
+        }
+    }
+    
+    // Copy constructor
+    MArray(const MArray<T>& other) : id(other.id), count(other.count) {
+        if (id != -1) {
+            GRPCClient::getInstance().IncreaseRefCount(id);
+        }
+    }
+    
+    // Move constructor (takes over the reference, no RPC)
+    MArray(MArray<T>&& other) noexcept : id(other.id), count(other.count) {
+        other.id = -1;
+        other.count = 0;
+    }
+    
+    // Assignment operator
+    MArray<T>& operator=(const MArray<T>& other) {
+        if (this != std::addressof(other)) {
+            if (id != -1) {
+                GRPCClient::getInstance().DecreaseRefCount(id);
+            }
+            
+            id = other.id;
+            count = other.count;
+            if (id != -1) {
+                GRPCClient::getInstance().IncreaseRefCount(id);
+            }
+        }
+        return *this;
+    }
+    
+    // Move assignment operator
+    MArray<T>& operator=(MArray<T>&& other) noexcept {
+        if (this != std::addressof(other)) {
+            if (id != -1) {
+                GRPCClient::getInstance().DecreaseRefCount(id);
+            }
+            
+            id = other.id;
+            count = other.count;
+            other.id = -1;
+            other.count = 0;
+        }
+        return *this;
+    }
+    
+    // Element access
+    Reference operator[](size_t index) {
+        return Reference(this, index);
+    }
+    
+    T operator[](size_t index) const {
+        return get(index);
+    }
+    
+    T get(size_t index) const {
+        T value;
+        read(index, 1, &value);
+        return value;
+    }
+    
+    void set(size_t index, const T& value) {
+        write(index, &value, 1);
+    }
+    
+    // Bulk read of elements [first, first + n)
+    std::vector<T> read(size_t first, size_t n) const {
+        std::vector<T> values(n);
+        read(first, n, values.data());
+        return values;
+    }
+    
+    void read(size_t first, size_t n, T* out) const {
+        checkRange(first, n);
+        
+        char* dest = reinterpret_cast<char*>(out);
+        size_t offset = first * sizeof(T);
+        size_t remaining = n * sizeof(T);
+        while (remaining > 0) {
+            size_t length = std::min(remaining, MAX_TRANSFER_BYTES);
+            size_t actualSize = 0;
+            bool success = GRPCClient::getInstance().GetRange(id, offset, dest, length, actualSize);
+            if (!success || actualSize != length) {
+                throw std::runtime_error("Failed to read range from memory");
+            }
+            dest += length;
+            offset += length;
+            remaining -= length;
+        }
+    }
+    
+    // Bulk write of elements starting at first
+    void write(size_t first, const std::vector<T>& values) {
+        write(first, values.data(), values.size());
+    }
+    
+    void write(size_t first, const T* values, size_t n) {
+        checkRange(first, n);
+        
+        const char* src = reinterpret_cast<const char*>(values);
+        size_t offset = first * sizeof(T);
+        size_t remaining = n * sizeof(T);
+        while (remaining > 0) {
+            size_t length = std::min(remaining, MAX_TRANSFER_BYTES);
+            if (!GRPCClient::getInstance().SetRange(id, offset, src, length)) {
+                throw std::runtime_error("Failed to write range to memory");
+            }
+            src += length;
+            offset += length;
+            remaining -= length;
+        }
+    }
+    
+    // Change the number of elements keeping the id, new elements are zeroed
+    void resize(size_t newCount) {
+        if (id == -1) {
+            throw std::runtime_error("Resizing null MArray");
+        }
+        if (newCount == 0) {
+            throw std::invalid_argument("MArray size must be greater than zero");
+        }
+        if (!GRPCClient::getInstance().Resize(id, newCount * sizeof(T))) {
+            throw std::runtime_error("Failed to resize memory block");
+        }
+        count = newCount;
+    }
+    
+    // Iteration
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, count); }
+    
+    // Number of elements
+    size_t size() const {
+        return count;
+    }
+    
+    // Address-of operator (returns id)
+    int64_t operator&() const {
+        return id;
+    }
+    
+    // Check if array is valid
+    bool isValid() const {
+        return id != -1;
+    }
+
+private:
+    void checkRange(size_t first, size_t n) const {
+        if (id == -1) {
+            throw std::runtime_error("Accessing null MArray");
+        }
+        if (first > count || n > count - first) {
+            throw std::out_of_range("MArray range out of bounds");
+        }
+    }
+    
+    int64_t id;   // Memory block ID in Memory Manager
+    size_t count; // Number of elements
+};
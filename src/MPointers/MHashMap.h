@@ -0,0 +1,374 @@
+#pragma once
+
+#include "MArray.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Hash map from K to V stored as an open-addressing table (linear probing)
+// in one Memory Manager block. A lookup reads PROBE_WINDOW buckets around
+// the key's home bucket with one ranged read, which is enough unless the
+// probe sequence runs longer than that.
+//
+// Growing allocates the next table and moves the old one over in steps of
+// MIGRATE_BUCKETS buckets, one step per insert or erase, so no single
+// operation pays for rehashing the whole map. While a migration is running
+// lookups check the new table first and then the part of the old table that
+// has not been moved yet.
+//
+// The element count lives in this handle, so MHashMap is move-only.
+template <typename K, typename V, typename Hash = std::hash<K>>
+class MHashMap {
+    static_assert(std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value,
+                  "MHashMap keys and values are transferred as raw bytes");
+
+public:
+    // Buckets fetched by one probe RPC
+    static constexpr size_t PROBE_WINDOW = 16;
+    // Old buckets moved to the new table per insert or erase while growing
+    static constexpr size_t MIGRATE_BUCKETS = 128;
+    // Buckets of the first table (the capacity is always a power of two)
+    static constexpr size_t INITIAL_CAPACITY = 64;
+    
+    MHashMap() : count(0), used(0), migrated(0) {}
+    
+    MHashMap(const MHashMap&) = delete;
+    MHashMap& operator=(const MHashMap&) = delete;
+    
+    MHashMap(MHashMap&& other) noexcept
+        : table(std::move(other.table)), oldTable(std::move(other.oldTable)),
+          count(std::exchange(other.count, 0)), used(std::exchange(other.used, 0)),
+          migrated(std::exchange(other.migrated, 0)) {}
+    
+    MHashMap& operator=(MHashMap&& other) noexcept {
+        if (this != std::addressof(other)) {
+            table = std::move(other.table);
+            oldTable = std::move(other.oldTable);
+            count = std::exchange(other.count, 0);
+            used = std::exchange(other.used, 0);
+            migrated = std::exchange(other.migrated, 0);
+        }
+        return *this;
+    }
+    
+    // Insert or overwrite, returns true when the key was not present
+    bool insert(const K& key, const V& value) {
+        if (!table.isValid()) {
+            table = MArray<Bucket>::New(INITIAL_CAPACITY);
+        }
+        migrateStep();
+        
+        Probe probe = find(table, key);
+        if (probe.found) {
+            probe.bucket.value = value;
+            table.set(probe.position, probe.bucket);
+            return false;
+        }
+        
+        // A key still waiting in the old table moves to the new one now
+        bool existed = false;
+        Probe old = findUnmigrated(key);
+        if (old.found) {
+            old.bucket.state = TOMBSTONE;
+            oldTable.set(old.position, old.bucket);
+            existed = true;
+        }
+        
+        Bucket bucket;
+        bucket.key = key;
+        bucket.value = value;
+        bucket.state = FULL;
+        place(probe, bucket);
+        if (!existed) {
+            count++;
+        }
+        
+        if (used * 2 > table.size()) {
+            startResize();
+        }
+        return !existed;
+    }
+    
+    // Look up key, one ranged read when the probe sequence is short
+    bool get(const K& key, V& value) const {
+        if (!table.isValid()) {
+            return false;
+        }
+        
+        Probe probe = find(table, key);
+        if (!probe.found) {
+            probe = findUnmigrated(key);
+        }
+        if (probe.found) {
+            value = probe.bucket.value;
+        }
+        return probe.found;
+    }
+    
+    V at(const K& key) const {
+        V value;
+        if (!get(key, value)) {
+            throw std::out_of_range("Key not found in MHashMap");
+        }
+        return value;
+    }
+    
+    bool contains(const K& key) const {
+        V value;
+        return get(key, value);
+    }
+    
+    // Remove key, returns true when it was present
+    bool erase(const K& key) {
+        if (!table.isValid()) {
+            return false;
+        }
+        migrateStep();
+        
+        bool erased = false;
+        Probe probe = find(table, key);
+        if (probe.found) {
+            probe.bucket.state = TOMBSTONE;
+            table.set(probe.position, probe.bucket);
+            erased = true;
+        } else {
+            probe = findUnmigrated(key);
+            if (probe.found) {
+                probe.bucket.state = TOMBSTONE;
+                oldTable.set(probe.position, probe.bucket);
+                erased = true;
+            }
+        }
+        
+        if (erased) {
+            count--;
+        }
+        return erased;
+    }
+    
+    size_t size() const {
+        return count;
+    }
+    
+    bool empty() const {
+        return count == 0;
+    }
+    
+    // Buckets in the current table
+    size_t capacity() const {
+        return table.size();
+    }
+    
+    // True while buckets are still being moved out of the previous table
+    bool isResizing() const {
+        return oldTable.isValid();
+    }
+    
+private:
+    enum : uint8_t {
+        EMPTY = 0, // New blocks come zeroed from the Memory Manager
+        FULL = 1,
+        TOMBSTONE = 2
+    };
+    
+    struct Bucket {
+        K key;
+        V value;
+        uint8_t state;
+    };
+    
+    struct Probe {
+        bool found = false;
+        size_t position = 0;     // Bucket holding the key when found
+        size_t freePosition = 0; // First bucket the key could be stored in otherwise
+        bool freeIsEmpty = false; // That bucket was never used (not a tombstone)
+        Bucket bucket{};
+    };
+    
+    // Contiguous copy of part of the new table used while migrating
+    struct Region {
+        size_t start;
+        std::vector<Bucket> buckets;
+    };
+    
+    static size_t homeBucket(const K& key, size_t capacity) {
+        // Mix the hash, std::hash is the identity for integers
+        uint64_t h = Hash{}(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return static_cast<size_t>(h) & (capacity - 1);
+    }
+    
+    // Walk the probe sequence of key PROBE_WINDOW buckets per RPC
+    static Probe find(const MArray<Bucket>& buckets, const K& key) {
+        Probe probe;
+        size_t capacity = buckets.size();
+        size_t position = homeBucket(key, capacity);
+        bool haveFree = false;
+        
+        for (size_t scanned = 0; scanned < capacity;) {
+            size_t n = std::min({PROBE_WINDOW, capacity - position, capacity - scanned});
+            std::vector<Bucket> window = buckets.read(position, n);
+            for (size_t i = 0; i < n; ++i) {
+                const Bucket& bucket = window[i];
+                if (bucket.state == FULL && bucket.key == key) {
+                    probe.found = true;
+                    probe.position = position + i;
+                    probe.bucket = bucket;
+                    return probe;
+                }
+                if (bucket.state != FULL && !haveFree) {
+                    probe.freePosition = position + i;
+                    probe.freeIsEmpty = bucket.state == EMPTY;
+                    haveFree = true;
+                }
+                if (bucket.state == EMPTY) {
+                    return probe;
+                }
+            }
+            scanned += n;
+            position = (position + n) & (capacity - 1);
+        }
+        
+        if (!haveFree) {
+            throw std::runtime_error("MHashMap table is full");
+        }
+        return probe;
+    }
+    
+    // Key in the part of the old table that has not been moved yet
+    Probe findUnmigrated(const K& key) const {
+        if (!oldTable.isValid()) {
+            return Probe();
+        }
+        Probe probe = find(oldTable, key);
+        // Buckets before the migration cursor already live in the new table
+        probe.found = probe.found && probe.position >= migrated;
+        return probe;
+    }
+    
+    // Store bucket at the free position find() reported
+    void place(const Probe& probe, const Bucket& bucket) {
+        if (probe.freeIsEmpty) {
+            used++;
+        }
+        table.set(probe.freePosition, bucket);
+    }
+    
+    void startResize() {
+        // A resize that catches up with a running migration finishes it first
+        while (oldTable.isValid()) {
+            migrateStep();
+        }
+        
+        // Double when the table is really filling up, otherwise just drop the tombstones
+        size_t newCapacity = count * 4 > table.size() ? table.size() * 2 : table.size();
+        oldTable = std::move(table);
+        table = MArray<Bucket>::New(newCapacity);
+        used = 0;
+        migrated = 0;
+    }
+    
+    // Move the next MIGRATE_BUCKETS old buckets. Entries are placed in local
+    // copies of the new table around their home buckets and written back with
+    // one ranged write per region; anything that probes past a region falls
+    // back to a normal insert
+    void migrateStep() {
+        if (!oldTable.isValid()) {
+            return;
+        }
+        
+        size_t oldCapacity = oldTable.size();
+        size_t capacity = table.size();
+        size_t n = std::min(MIGRATE_BUCKETS, oldCapacity - migrated);
+        std::vector<Bucket> chunk = oldTable.read(migrated, n);
+        
+        std::vector<std::pair<size_t, Bucket>> entries;
+        for (const Bucket& bucket : chunk) {
+            if (bucket.state == FULL) {
+                entries.emplace_back(homeBucket(bucket.key, capacity), bucket);
+            }
+        }
+        std::sort(entries.begin(), entries.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+        
+        // Homes cluster around at most two spots of the new table (the same
+        // index and index + old capacity), split at the largest gap
+        std::vector<Region> regions;
+        if (!entries.empty()) {
+            size_t split = entries.size();
+            size_t largestGap = 0;
+            for (size_t i = 1; i < entries.size(); ++i) {
+                size_t gap = entries[i].first - entries[i - 1].first;
+                if (gap > largestGap) {
+                    largestGap = gap;
+                    split = i;
+                }
+            }
+            if (largestGap <= MIGRATE_BUCKETS + 2 * PROBE_WINDOW) {
+                split = entries.size();
+            }
+            addRegion(regions, entries.front().first, entries[split - 1].first, split, capacity);
+            if (split < entries.size()) {
+                addRegion(regions, entries[split].first, entries.back().first, entries.size() - split, capacity);
+            }
+        }
+        
+        std::vector<Bucket> overflow;
+        for (const auto& entry : entries) {
+            if (!placeInRegions(regions, entry.first, entry.second)) {
+                overflow.push_back(entry.second);
+            }
+        }
+        for (const Region& region : regions) {
+            table.write(region.start, region.buckets);
+        }
+        for (const Bucket& bucket : overflow) {
+            place(find(table, bucket.key), bucket);
+        }
+        
+        migrated += n;
+        if (migrated == oldCapacity) {
+            oldTable = MArray<Bucket>();
+            migrated = 0;
+        }
+    }
+    
+    void addRegion(std::vector<Region>& regions, size_t firstHome, size_t lastHome, size_t entries, size_t capacity) {
+        Region region;
+        region.start = firstHome;
+        size_t end = std::min(capacity, lastHome + entries + PROBE_WINDOW);
+        region.buckets = table.read(region.start, end - region.start);
+        regions.push_back(std::move(region));
+    }
+    
+    bool placeInRegions(std::vector<Region>& regions, size_t home, const Bucket& bucket) {
+        for (Region& region : regions) {
+            if (home < region.start || home >= region.start + region.buckets.size()) {
+                continue;
+            }
+            for (size_t i = home - region.start; i < region.buckets.size(); ++i) {
+                if (region.buckets[i].state != FULL) {
+                    if (region.buckets[i].state == EMPTY) {
+                        used++;
+                    }
+                    region.buckets[i] = bucket;
+                    return true;
+                }
+            }
+            return false;
+        }
+        return false;
+    }
+    
+    MArray<Bucket> table;    // Current table, new keys always go here
+    MArray<Bucket> oldTable; // Table being migrated, invalid when not resizing
+    size_t count;            // Keys in the map
+    size_t used;             // Full or tombstone buckets in table
+    size_t migrated;         // Old buckets already moved to table
+};
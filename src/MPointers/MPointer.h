@@ -3,15 +3,22 @@
 #include "GRPCClient.h"
 #include <iostream>
 #include <string>
-#include <typeinfo>
 #include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
 
 template <typename T>
 class MPointer {
 public:
     // Initialize connection to Memory Manager
     static void Init(int port) {
-        std::string server_address = "localhost:" + std::to_string(port);
+        Init("localhost:" + std::to_string(port));
+    }
+    
+    // Initialize connection with a full address, e.g. "unix:/tmp/mem-mgr.sock",
+    // or a comma-separated list to spread blocks over several Memory Managers
+    static void Init(const std::string& server_address) {
         if (!GRPCClient::getInstance().Connect(server_address)) {
             throw std::runtime_error("Failed to connect to Memory Manager");
         }
@@ -20,13 +27,17 @@ public:
     // Default constructor
     MPointer() : id(-1) {}
     
+    // Wrap an id whose reference the caller already owns (no RPC)
+    static MPointer<T> Adopt(int64_t id) {
+        MPointer<T> ptr;
+        ptr.id = id;
+        return ptr;
+    }
+    
     // Create a new pointer (allocate memory)
     static MPointer<T> New() {
         MPointer<T> ptr;
-        size_t size = sizeof(T);
-        std::string type = typeid(T).name();
-        
-        ptr.id = GRPCClient::getInstance().Create(size, type);
+        ptr.id = GRPCClient::getInstance().Create(sizeof(T), TypeDescriptorOf<T>());
         if (ptr.id == -1) {
             throw std::runtime_error("Failed to create memory block");
         }
@@ -48,9 +59,14 @@ public:
         }
     }
     
+    // Move constructor (takes over the reference, no RPC)
+    MPointer(MPointer<T>&& other) noexcept : id(other.id) {
+        other.id = -1;
+    }
+    
     // Assignment operator
     MPointer<T>& operator=(const MPointer<T>& other) {
-        if (this != &other) {
+        if (this != std::addressof(other)) {
             // Decrease reference count for current id
             if (id != -1) {
                 GRPCClient::getInstance().DecreaseRefCount(id);
@@ -65,13 +81,27 @@ public:
         return *this;
     }
     
-    // Dereference operator (for value access)
-    T operator*() const {
+    // Move assignment operator (releases the current block, takes over the other's reference)
+    MPointer<T>& operator=(MPointer<T>&& other) noexcept {
+        if (this != std::addressof(other)) {
+            if (id != -1) {
+                GRPCClient::getInstance().DecreaseRefCount(id);
+            }
+            
+            id = other.id;
+            other.id = -1;
+        }
+        return *this;
+    }
+    
+    // Dereference operator (for value access, arrays are read through GRPCClient directly)
+    template <typename U = T, typename = std::enable_if_t<!std::is_array<U>::value>>
+    U operator*() const {
         if (id == -1) {
             throw std::runtime_error("Dereferencing null MPointer");
         }
         
-        T value;
+        U value;
         size_t actualSize = 0;
         bool success = GRPCClient::getInstance().Get(id, &value, sizeof(T), actualSize);
         
@@ -94,8 +124,40 @@ public:
         }
     }
     
+    // Atomic updates applied by the Memory Manager in one round trip, for
+    // 4- and 8-byte integers. Each returns the value held before the update
+    template <typename U = T, typename = std::enable_if_t<std::is_integral<U>::value && (sizeof(U) == 4 || sizeof(U) == 8)>>
+    U fetchAdd(T delta) {
+        int64_t previous = 0;
+        if (id == -1 || !GRPCClient::getInstance().FetchAdd(id, 0, sizeof(U), delta, previous)) {
+            throw std::runtime_error("Failed to apply atomic operation");
+        }
+        return static_cast<U>(previous);
+    }
+    
+    template <typename U = T, typename = std::enable_if_t<std::is_integral<U>::value && (sizeof(U) == 4 || sizeof(U) == 8)>>
+    U exchange(T value) {
+        int64_t previous = 0;
+        if (id == -1 || !GRPCClient::getInstance().Exchange(id, 0, sizeof(U), value, previous)) {
+            throw std::runtime_error("Failed to apply atomic operation");
+        }
+        return static_cast<U>(previous);
+    }
+    
+    // Stores desired if the value equals expected, otherwise loads the current value into expected
+    template <typename U = T, typename = std::enable_if_t<std::is_integral<U>::value && (sizeof(U) == 4 || sizeof(U) == 8)>>
+    bool compareExchange(T& expected, T desired) {
+        int64_t previous = 0;
+        if (id == -1 || !GRPCClient::getInstance().CompareExchange(id, 0, sizeof(U), expected, desired, previous)) {
+            throw std::runtime_error("Failed to apply atomic operation");
+        }
+        bool exchanged = static_cast<U>(previous) == expected;
+        expected = static_cast<U>(previous);
+        return exchanged;
+    }
+    
     // Address-of operator (returns id)
-    int operator&() const {
+    int64_t operator&() const {
         return id;
     }
     
@@ -105,5 +167,5 @@ public:
     }
     
 private:
-    int id; // Memory block ID in Memory Manager
+    int64_t id; // Memory block ID in Memory Manager
 };
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "GRPCClient.h"
+#include <stdexcept>
+
+// Region of Memory Manager blocks that die together. Every MPointer,
+// MArray or container node created by this thread while the scope is
+// alive is tagged with the region: copies and destructors of those
+// pointers send no refcount RPCs, and leaving the scope frees all of the
+// blocks with a single ReleaseRegion RPC.
+//
+// Pointers into the region must not outlive the scope.
+//
+//     {
+//         MScope scope;
+//         MPointer<int> temp = MPointer<int>::New();
+//         ...
+//     } // One RPC frees every block created above
+class MScope {
+public:
+    MScope() : regionId(GRPCClient::getInstance().CreateRegion()), released(false) {
+        if (regionId == -1) {
+            throw std::runtime_error("Failed to create memory region");
+        }
+        GRPCClient::getInstance().EnterRegion(regionId);
+    }
+    
+    ~MScope() {
+        release();
+    }
+    
+    MScope(const MScope&) = delete;
+    MScope& operator=(const MScope&) = delete;
+    
+    // Free the region now instead of at the end of the scope
+    void release() {
+        if (!released) {
+            released = true;
+            GRPCClient::getInstance().LeaveRegion(regionId);
+            GRPCClient::getInstance().ReleaseRegion(regionId);
+        }
+    }
+    
+    int64_t id() const {
+        return regionId;
+    }
+    
+private:
+    int64_t regionId;
+    bool released;
+};
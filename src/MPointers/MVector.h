@@ -0,0 +1,150 @@
+#pragma once
+
+#include "MArray.h"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Growable array of T kept in one Memory Manager block. The block is
+// resized in place on the server (its id never changes) and grows
+// geometrically, so push_back costs one RPC plus an amortized constant.
+// The element count lives in this handle, which is why it is move-only.
+template <typename T>
+class MVector {
+public:
+    using const_iterator = typename MArray<T>::const_iterator;
+    
+    // Capacity of the first allocation
+    static constexpr size_t INITIAL_CAPACITY = 16;
+    
+    MVector() : count(0) {}
+    
+    MVector(const MVector<T>&) = delete;
+    MVector<T>& operator=(const MVector<T>&) = delete;
+    
+    MVector(MVector<T>&& other) noexcept : storage(std::move(other.storage)), count(other.count) {
+        other.count = 0;
+    }
+    
+    MVector<T>& operator=(MVector<T>&& other) noexcept {
+        if (this != std::addressof(other)) {
+            storage = std::move(other.storage);
+            count = other.count;
+            other.count = 0;
+        }
+        return *this;
+    }
+    
+    // Append one element (one SetRange, plus a Resize when the block is full)
+    void push_back(const T& value) {
+        reserveForAppend(1);
+        storage.set(count, value);
+        count++;
+    }
+    
+    // Append many elements with at most one Resize and one RPC per MArray::MAX_TRANSFER_BYTES
+    void append(const std::vector<T>& values) {
+        append(values.data(), values.size());
+    }
+    
+    void append(const T* values, size_t n) {
+        if (n == 0) {
+            return;
+        }
+        reserveForAppend(n);
+        storage.write(count, values, n);
+        count += n;
+    }
+    
+    // Drop the last element (no RPC, the bytes are overwritten by the next push)
+    void pop_back() {
+        if (count == 0) {
+            throw std::out_of_range("pop_back on empty MVector");
+        }
+        count--;
+    }
+    
+    // Element access, one RPC per read or write
+    typename MArray<T>::Reference operator[](size_t index) {
+        checkIndex(index);
+        return storage[index];
+    }
+    
+    T operator[](size_t index) const {
+        return get(index);
+    }
+    
+    T get(size_t index) const {
+        checkIndex(index);
+        return storage.get(index);
+    }
+    
+    void set(size_t index, const T& value) {
+        checkIndex(index);
+        storage.set(index, value);
+    }
+    
+    // Bulk read of elements [first, first + n)
+    std::vector<T> read(size_t first, size_t n) const {
+        if (first > count || n > count - first) {
+            throw std::out_of_range("MVector range out of bounds");
+        }
+        return storage.read(first, n);
+    }
+    
+    // Make room for at least newCapacity elements with a single Resize
+    void reserve(size_t newCapacity) {
+        if (newCapacity <= capacity()) {
+            return;
+        }
+        if (!storage.isValid()) {
+            storage = MArray<T>::New(newCapacity);
+        } else {
+            storage.resize(newCapacity);
+        }
+    }
+    
+    // Forget all elements, the block keeps its capacity
+    void clear() {
+        count = 0;
+    }
+    
+    // Iteration (fetches MArray<T>::CHUNK_ELEMENTS elements per RPC)
+    const_iterator begin() const { return const_iterator(std::addressof(storage), 0); }
+    const_iterator end() const { return const_iterator(std::addressof(storage), count); }
+    
+    size_t size() const {
+        return count;
+    }
+    
+    size_t capacity() const {
+        return storage.size();
+    }
+    
+    bool empty() const {
+        return count == 0;
+    }
+    
+    // Address-of operator (returns id, stable across growth)
+    int64_t operator&() const {
+        return &storage;
+    }
+    
+private:
+    void reserveForAppend(size_t n) {
+        if (count + n > capacity()) {
+            reserve(std::max({count + n, capacity() * 2, INITIAL_CAPACITY}));
+        }
+    }
+    
+    void checkIndex(size_t index) const {
+        if (index >= count) {
+            throw std::out_of_range("MVector index out of range");
+        }
+    }
+    
+    MArray<T> storage; // Backing block, its size is the capacity
+    size_t count;      // Number of elements in use
+};
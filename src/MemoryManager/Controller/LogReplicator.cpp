@@ -0,0 +1,126 @@
+#include "LogReplicator.h"
+#include <iostream>
+
+namespace {
+
+// Ship at most this much per ApplyLog call (a single larger record still goes alone)
+constexpr size_t REPLICATION_BATCH_BYTES = 1024 * 1024;
+// Give up on a follower that is this far behind, it has to be reseeded from a snapshot
+constexpr size_t REPLICATION_MAX_PENDING_BYTES = 256 * 1024 * 1024;
+constexpr auto REPLICATION_TIMEOUT = std::chrono::seconds(5);
+
+} // namespace
+
+LogReplicator::LogReplicator(const std::string& followerAddress, std::chrono::milliseconds interval)
+    : address(followerAddress), interval(interval), pendingBytes(0), reachable(true), detached(false),
+      stopping(false) {
+    stub = mpointers::MemoryManager::NewStub(grpc::CreateChannel(address, grpc::InsecureChannelCredentials()));
+    sendThread = std::thread(&LogReplicator::SendTask, this);
+}
+
+LogReplicator::~LogReplicator() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    sendNeeded.notify_one();
+    sendThread.join();
+}
+
+void LogReplicator::Append(uint64_t sequence, LogRecordType type, const std::string& body) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (detached) {
+        return;
+    }
+    
+    if (pendingBytes + body.size() > REPLICATION_MAX_PENDING_BYTES) {
+        std::cerr << "Follower " << address << " fell too far behind, replication stopped. "
+                  << "Restart it from a snapshot of this Memory Manager" << std::endl;
+        detached = true;
+        pending.clear();
+        pendingBytes = 0;
+        return;
+    }
+    
+    pending.emplace_back();
+    pending.back().set_sequence(sequence);
+    pending.back().set_type(static_cast<int>(type));
+    pending.back().set_body(body);
+    pendingBytes += body.size();
+    
+    if (pendingBytes >= REPLICATION_BATCH_BYTES) {
+        sendNeeded.notify_one();
+    }
+}
+
+void LogReplicator::SendTask() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        // Let a batch build up for one interval unless it is already large
+        sendNeeded.wait_for(lock, interval, [this]() {
+            return stopping || pendingBytes >= REPLICATION_BATCH_BYTES;
+        });
+        if (pending.empty()) {
+            if (stopping) {
+                break;
+            }
+            continue;
+        }
+        
+        // On shutdown keep draining while the follower answers
+        if (!SendBatch(lock) && stopping) {
+            break;
+        }
+    }
+}
+
+bool LogReplicator::SendBatch(std::unique_lock<std::mutex>& lock) {
+    mpointers::ApplyLogRequest request;
+    size_t batchBytes = 0;
+    for (const auto& record : pending) {
+        if (request.records_size() > 0 && batchBytes + record.body().size() > REPLICATION_BATCH_BYTES) {
+            break;
+        }
+        *request.add_records() = record;
+        batchBytes += record.body().size();
+    }
+    
+    // Appends keep going while the batch is in flight
+    lock.unlock();
+    mpointers::ApplyLogResponse response;
+    grpc::ClientContext context;
+    context.set_deadline(std::chrono::system_clock::now() + REPLICATION_TIMEOUT);
+    grpc::Status status = stub->ApplyLog(&context, request, &response);
+    lock.lock();
+    
+    if (detached) {
+        return false;
+    }
+    if (!status.ok()) {
+        if (reachable) {
+            std::cerr << "Follower " << address << " unreachable (" << status.error_message()
+                      << "), keeping records until it is back" << std::endl;
+            reachable = false;
+        }
+        return false;
+    }
+    if (!reachable) {
+        std::cout << "Follower " << address << " reachable again" << std::endl;
+        reachable = true;
+    }
+    if (!response.success()) {
+        std::cerr << "Follower " << address << " rejected the log (" << response.error_message()
+                  << "), replication stopped. Restart it from a snapshot of this Memory Manager" << std::endl;
+        detached = true;
+        pending.clear();
+        pendingBytes = 0;
+        return false;
+    }
+    
+    // Append only adds at the back (or detaches, checked above), so the batch is still at the front
+    for (int i = 0; i < request.records_size(); ++i) {
+        pendingBytes -= pending.front().body().size();
+        pending.pop_front();
+    }
+    return true;
+}
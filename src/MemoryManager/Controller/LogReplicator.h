@@ -0,0 +1,46 @@
+#pragma once
+
+#include "../Model/WriteAheadLog.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <grpcpp/grpcpp.h>
+#include "mpointers.grpc.pb.h"
+
+// Streams the primary's mutation records to a follower mem-mgr. Append only
+// queues a record, a sender thread ships whatever is queued with one ApplyLog
+// call per interval, so clients of the primary never wait for the follower.
+// Records stay queued until the follower acknowledges them and are resent
+// after a failure, which the follower skips if it already applied them
+class LogReplicator {
+public:
+    LogReplicator(const std::string& followerAddress, std::chrono::milliseconds interval);
+    ~LogReplicator();
+    
+    LogReplicator(const LogReplicator&) = delete;
+    LogReplicator& operator=(const LogReplicator&) = delete;
+    
+    // Called in sequence order (under the model's log lock)
+    void Append(uint64_t sequence, LogRecordType type, const std::string& body);
+    
+private:
+    void SendTask();
+    bool SendBatch(std::unique_lock<std::mutex>& lock);
+    
+    std::string address;
+    std::chrono::milliseconds interval;
+    std::unique_ptr<mpointers::MemoryManager::Stub> stub;
+    
+    std::mutex mutex;
+    std::condition_variable sendNeeded;
+    std::deque<mpointers::LogRecord> pending; // Not acknowledged by the follower yet
+    size_t pendingBytes;
+    bool reachable;  // Last call reached the follower, only used to report changes
+    bool detached;   // Follower can no longer catch up, records are dropped
+    bool stopping;
+    std::thread sendThread;
+};
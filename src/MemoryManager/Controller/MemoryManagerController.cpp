@@ -1,13 +1,80 @@
 #include "MemoryManagerController.h"
+#include "NumaPlacement.h"
+#include "TenantMetadata.h"
 #include <iostream>
+#include <stdexcept>
+#include <unistd.h>
 
-MemoryManagerServiceImpl::MemoryManagerServiceImpl(MemoryManagerModel* model, MemoryManagerView* view)
-    : model(model), view(view) {}
+namespace {
+
+// How long the primary lets records build up before shipping them to its follower
+constexpr int REPLICATION_INTERVAL_MS = 5;
+constexpr int FOLLOWER_MAX_MESSAGE_BYTES = 16 * 1024 * 1024;
+
+} // namespace
+
+MemoryManagerServiceImpl::MemoryManagerServiceImpl(MemoryManagerModel* model, MemoryManagerView* view,
+                                                   bool follower,
+                                                   const std::unordered_map<std::string, TenantArena>& tenants)
+    : model(model), view(view), tenants(tenants), follower(follower) {
+    this->tenants[""] = TenantArena{model, view};
+}
+
+const TenantArena* MemoryManagerServiceImpl::FindTenant(grpc::ServerContext* context) const {
+    const auto& metadata = context->client_metadata();
+    auto entry = metadata.find(TENANT_METADATA_KEY);
+    std::string name = entry == metadata.end() ? "" : std::string(entry->second.data(), entry->second.size());
+    auto tenant = tenants.find(name);
+    return tenant == tenants.end() ? nullptr : &tenant->second;
+}
+
+grpc::Status MemoryManagerServiceImpl::UnknownTenant() {
+    return grpc::Status(grpc::StatusCode::NOT_FOUND, "Unknown tenant");
+}
+
+grpc::Status MemoryManagerServiceImpl::NotDurable() {
+    return grpc::Status(grpc::StatusCode::UNAVAILABLE, "Change did not reach the write-ahead log");
+}
+
+template <typename Response>
+bool MemoryManagerServiceImpl::RejectOnFollower(Response* response) {
+    if (!follower) {
+        return false;
+    }
+    response->set_success(false);
+    response->set_error_message("Memory Manager is a read-only follower");
+    return true;
+}
 
 grpc::Status MemoryManagerServiceImpl::Create(grpc::ServerContext* context, 
                                         const mpointers::CreateRequest* request,
                                         mpointers::CreateResponse* response) {
-    int id = model->Create(request->size(), request->type());
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    if (RejectOnFollower(response)) {
+        return grpc::Status::OK;
+    }
+    
+    if (request->size() <= 0) {
+        response->set_id(-1);
+        response->set_success(false);
+        response->set_error_message("Invalid size");
+        return grpc::Status::OK;
+    }
+    
+    int64_t id = -1;
+    if (request->type_id() != 0) {
+        id = tenant->model->Create(request->size(), request->type_id(), request->region());
+    } else if (request->region() == 0) {
+        id = tenant->model->Create(request->size(), request->type());
+    }
+    // Answer only once the change is durable in the write-ahead log
+    if (!tenant->model->SyncLog()) {
+        return NotDurable();
+    }
     
     response->set_id(id);
     response->set_success(id != -1);
@@ -15,8 +82,126 @@ grpc::Status MemoryManagerServiceImpl::Create(grpc::ServerContext* context,
         response->set_error_message("Failed to allocate memory block");
     }
     
+    // Let shared-memory clients reach the block without a Locate call
+    int slot = -1;
+    if (id != -1) {
+        tenant->model->Locate(id, slot);
+    }
+    response->set_slot(slot);
+    response->set_free_bytes(tenant->model->GetFreeMemory());
+    
     // Generate memory dump after modifying memory
-    view->GenerateDump();
+    tenant->view->GenerateDump();
+    
+    return grpc::Status::OK;
+}
+
+grpc::Status MemoryManagerServiceImpl::RegisterType(grpc::ServerContext* context, 
+                                             const mpointers::RegisterTypeRequest* request,
+                                             mpointers::RegisterTypeResponse* response) {
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    if (RejectOnFollower(response)) {
+        return grpc::Status::OK;
+    }
+    
+    if (request->name().empty() || request->size() < 0 || request->alignment() < 0) {
+        response->set_success(false);
+        response->set_error_message("Invalid type descriptor");
+        return grpc::Status::OK;
+    }
+    
+    TypeDescriptor type{request->name(), static_cast<uint32_t>(request->size()),
+                        static_cast<uint32_t>(request->alignment()), request->hash()};
+    int typeId = tenant->model->RegisterType(type);
+    if (!tenant->model->SyncLog()) {
+        return NotDurable();
+    }
+    
+    response->set_type_id(typeId);
+    response->set_success(typeId != -1);
+    if (typeId == -1) {
+        response->set_error_message("Type hash already registered for another type");
+    }
+    
+    return grpc::Status::OK;
+}
+
+grpc::Status MemoryManagerServiceImpl::CreateRegion(grpc::ServerContext* context, 
+                                             const mpointers::CreateRegionRequest* request,
+                                             mpointers::CreateRegionResponse* response) {
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    if (RejectOnFollower(response)) {
+        return grpc::Status::OK;
+    }
+    
+    response->set_region_id(tenant->model->CreateRegion());
+    if (!tenant->model->SyncLog()) {
+        return NotDurable();
+    }
+    response->set_success(true);
+    return grpc::Status::OK;
+}
+
+grpc::Status MemoryManagerServiceImpl::ReleaseRegion(grpc::ServerContext* context, 
+                                              const mpointers::ReleaseRegionRequest* request,
+                                              mpointers::ReleaseRegionResponse* response) {
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    if (RejectOnFollower(response)) {
+        return grpc::Status::OK;
+    }
+    
+    int released = tenant->model->ReleaseRegion(request->region_id());
+    if (!tenant->model->SyncLog()) {
+        return NotDurable();
+    }
+    
+    response->set_success(released != -1);
+    if (released == -1) {
+        response->set_error_message("Region not found");
+    } else {
+        response->set_released_blocks(released);
+    }
+    
+    // Generate memory dump after modifying memory
+    tenant->view->GenerateDump();
+    
+    return grpc::Status::OK;
+}
+
+grpc::Status MemoryManagerServiceImpl::Snapshot(grpc::ServerContext* context, 
+                                         const mpointers::SnapshotRequest* request,
+                                         mpointers::SnapshotResponse* response) {
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    if (request->path().empty()) {
+        response->set_success(false);
+        response->set_error_message("Missing snapshot path");
+        return grpc::Status::OK;
+    }
+    
+    long long written = tenant->model->SaveSnapshot(request->path());
+    
+    response->set_success(written != -1);
+    if (written == -1) {
+        response->set_error_message("Failed to write snapshot to " + request->path());
+    } else {
+        response->set_bytes_written(written);
+    }
     
     return grpc::Status::OK;
 }
@@ -24,7 +209,19 @@ grpc::Status MemoryManagerServiceImpl::Create(grpc::ServerContext* context,
 grpc::Status MemoryManagerServiceImpl::Set(grpc::ServerContext* context, 
                                     const mpointers::SetRequest* request,
                                     mpointers::SetResponse* response) {
-    bool success = model->Set(request->id(), request->value().data(), request->value().size());
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    if (RejectOnFollower(response)) {
+        return grpc::Status::OK;
+    }
+    
+    bool success = tenant->model->Set(request->id(), request->value().data(), request->value().size());
+    if (!tenant->model->SyncLog()) {
+        return NotDurable();
+    }
     
     response->set_success(success);
     if (!success) {
@@ -32,7 +229,7 @@ grpc::Status MemoryManagerServiceImpl::Set(grpc::ServerContext* context,
     }
     
     // Generate memory dump after modifying memory
-    view->GenerateDump();
+    tenant->view->GenerateDump();
     
     return grpc::Status::OK;
 }
@@ -40,17 +237,18 @@ grpc::Status MemoryManagerServiceImpl::Set(grpc::ServerContext* context,
 grpc::Status MemoryManagerServiceImpl::Get(grpc::ServerContext* context, 
                                     const mpointers::GetRequest* request,
                                     mpointers::GetResponse* response) {
-    // We need a temporary buffer - we'll use 1MB as a reasonable max size
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    // Read straight into the response, capped at 1MB as before
     const size_t MAX_SIZE = 1024 * 1024;
-    std::vector<char> buffer(MAX_SIZE);
-    size_t actualSize = 0;
     
-    bool success = model->Get(request->id(), buffer.data(), MAX_SIZE, actualSize);
+    bool success = tenant->model->GetRange(request->id(), 0, MAX_SIZE, *response->mutable_value());
     
     response->set_success(success);
-    if (success) {
-        response->set_value(buffer.data(), actualSize);
-    } else {
+    if (!success) {
         response->set_error_message("Failed to get value from memory block");
     }
     
@@ -60,7 +258,19 @@ grpc::Status MemoryManagerServiceImpl::Get(grpc::ServerContext* context,
 grpc::Status MemoryManagerServiceImpl::IncreaseRefCount(grpc::ServerContext* context, 
                                                 const mpointers::RefCountRequest* request,
                                                 mpointers::RefCountResponse* response) {
-    bool success = model->IncreaseRefCount(request->id());
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    if (RejectOnFollower(response)) {
+        return grpc::Status::OK;
+    }
+    
+    bool success = tenant->model->IncreaseRefCount(request->id());
+    if (!tenant->model->SyncLog()) {
+        return NotDurable();
+    }
     
     response->set_success(success);
     if (!success) {
@@ -73,7 +283,19 @@ grpc::Status MemoryManagerServiceImpl::IncreaseRefCount(grpc::ServerContext* con
 grpc::Status MemoryManagerServiceImpl::DecreaseRefCount(grpc::ServerContext* context, 
                                                 const mpointers::RefCountRequest* request,
                                                 mpointers::RefCountResponse* response) {
-    bool success = model->DecreaseRefCount(request->id());
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    if (RejectOnFollower(response)) {
+        return grpc::Status::OK;
+    }
+    
+    bool success = tenant->model->DecreaseRefCount(request->id());
+    if (!tenant->model->SyncLog()) {
+        return NotDurable();
+    }
     
     response->set_success(success);
     if (!success) {
@@ -81,23 +303,367 @@ grpc::Status MemoryManagerServiceImpl::DecreaseRefCount(grpc::ServerContext* con
     }
     
     // Generate memory dump after potentially modifying memory state
+    tenant->view->GenerateDump();
+    
+    return grpc::Status::OK;
+}
+
+grpc::Status MemoryManagerServiceImpl::GetRange(grpc::ServerContext* context, 
+                                         const mpointers::GetRangeRequest* request,
+                                         mpointers::GetResponse* response) {
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    if (request->offset() < 0 || request->length() < 0) {
+        response->set_success(false);
+        response->set_error_message("Invalid range");
+        return grpc::Status::OK;
+    }
+    
+    bool success = tenant->model->GetRange(request->id(), request->offset(), request->length(),
+                                   *response->mutable_value());
+    
+    response->set_success(success);
+    if (!success) {
+        response->set_error_message("Failed to get range from memory block");
+    }
+    
+    return grpc::Status::OK;
+}
+
+grpc::Status MemoryManagerServiceImpl::SetRange(grpc::ServerContext* context, 
+                                         const mpointers::SetRangeRequest* request,
+                                         mpointers::SetResponse* response) {
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    if (RejectOnFollower(response)) {
+        return grpc::Status::OK;
+    }
+    
+    if (request->offset() < 0) {
+        response->set_success(false);
+        response->set_error_message("Invalid range");
+        return grpc::Status::OK;
+    }
+    
+    bool success = tenant->model->SetRange(request->id(), request->offset(),
+                                   request->value().data(), request->value().size());
+    if (!tenant->model->SyncLog()) {
+        return NotDurable();
+    }
+    
+    response->set_success(success);
+    if (!success) {
+        response->set_error_message("Failed to set range in memory block");
+    }
+    
+    // Generate memory dump after modifying memory
+    tenant->view->GenerateDump();
+    
+    return grpc::Status::OK;
+}
+
+grpc::Status MemoryManagerServiceImpl::GetBatch(grpc::ServerContext* context, 
+                                         const mpointers::GetBatchRequest* request,
+                                         mpointers::GetBatchResponse* response) {
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    std::vector<int64_t> ids(request->ids().begin(), request->ids().end());
+    std::vector<std::string> values;
+    
+    bool success = tenant->model->GetBatch(ids, values);
+    
+    response->set_success(success);
+    if (success) {
+        for (auto& value : values) {
+            response->add_values(std::move(value));
+        }
+    } else {
+        response->set_error_message("Failed to get one or more memory blocks");
+    }
+    
+    return grpc::Status::OK;
+}
+
+grpc::Status MemoryManagerServiceImpl::Traverse(grpc::ServerContext* context, 
+                                         const mpointers::TraverseRequest* request,
+                                         mpointers::TraverseResponse* response) {
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    if (request->next_offset() < 0 || request->skip() < 0 || request->max_count() < 0) {
+        response->set_success(false);
+        response->set_error_message("Invalid traversal parameters");
+        return grpc::Status::OK;
+    }
+    
+    std::vector<std::string> values;
+    int64_t nextId = -1;
+    int skipped = 0;
+    
+    bool success = tenant->model->Traverse(request->start_id(), request->next_offset(), request->skip(),
+                                   request->max_count(), values, nextId, skipped,
+                                   request->sharded() ? request->shard() : -1);
+    
+    response->set_success(success);
+    if (success) {
+        for (auto& value : values) {
+            response->add_values(std::move(value));
+        }
+        response->set_next_id(nextId);
+        response->set_skipped(skipped);
+    } else {
+        response->set_error_message("Failed to traverse memory blocks");
+    }
+    
+    return grpc::Status::OK;
+}
+
+grpc::Status MemoryManagerServiceImpl::Resize(grpc::ServerContext* context, 
+                                       const mpointers::ResizeRequest* request,
+                                       mpointers::ResizeResponse* response) {
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    if (RejectOnFollower(response)) {
+        return grpc::Status::OK;
+    }
+    
+    if (request->new_size() <= 0) {
+        response->set_success(false);
+        response->set_error_message("Invalid size");
+        return grpc::Status::OK;
+    }
+    
+    bool success = tenant->model->Resize(request->id(), request->new_size());
+    if (!tenant->model->SyncLog()) {
+        return NotDurable();
+    }
+    
+    response->set_success(success);
+    if (!success) {
+        response->set_error_message("Failed to resize memory block");
+    }
+    
+    // Generate memory dump after modifying memory
+    tenant->view->GenerateDump();
+    
+    return grpc::Status::OK;
+}
+
+grpc::Status MemoryManagerServiceImpl::Atomic(grpc::ServerContext* context, 
+                                       const mpointers::AtomicRequest* request,
+                                       mpointers::AtomicResponse* response) {
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    if (RejectOnFollower(response)) {
+        return grpc::Status::OK;
+    }
+    
+    if (request->offset() < 0 || request->width() <= 0) {
+        response->set_success(false);
+        response->set_error_message("Invalid atomic word");
+        return grpc::Status::OK;
+    }
+    
+    BlockAtomicOp op;
+    switch (request->op()) {
+        case mpointers::FETCH_ADD: op = BlockAtomicOp::FetchAdd; break;
+        case mpointers::COMPARE_EXCHANGE: op = BlockAtomicOp::CompareExchange; break;
+        case mpointers::EXCHANGE: op = BlockAtomicOp::Exchange; break;
+        default:
+            response->set_success(false);
+            response->set_error_message("Unknown atomic operation");
+            return grpc::Status::OK;
+    }
+    
+    int64_t previous = 0;
+    bool success = tenant->model->Atomic(request->id(), request->offset(), request->width(), op,
+                                 request->operand(), request->expected(), previous);
+    if (!tenant->model->SyncLog()) {
+        return NotDurable();
+    }
+    
+    response->set_success(success);
+    if (success) {
+        response->set_previous(previous);
+    } else {
+        response->set_error_message("Failed to apply atomic operation (block missing or word not aligned)");
+    }
+    
+    // Generate memory dump after modifying memory
+    tenant->view->GenerateDump();
+    
+    return grpc::Status::OK;
+}
+
+grpc::Status MemoryManagerServiceImpl::GetArenaInfo(grpc::ServerContext* context, 
+                                             const mpointers::ArenaInfoRequest* request,
+                                             mpointers::ArenaInfoResponse* response) {
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    // Writes through shared memory would bypass the write-ahead log, the
+    // follower and a follower's read-only check, and spilled blocks have no
+    // slot to read, so these keep clients on gRPC
+    const SharedArena* sharedArena = tenant->model->GetSharedArena();
+    if (sharedArena && tenant->model->AllowsSharedAccess() && !follower) {
+        response->set_shm_name(sharedArena->GetName());
+        response->set_segment_size(sharedArena->GetSegmentSize());
+    }
+    
+    return grpc::Status::OK;
+}
+
+grpc::Status MemoryManagerServiceImpl::Locate(grpc::ServerContext* context, 
+                                       const mpointers::LocateRequest* request,
+                                       mpointers::LocateResponse* response) {
+    const TenantArena* tenant = FindTenant(context);
+    if (!tenant) {
+        return UnknownTenant();
+    }
+    
+    int slot = -1;
+    bool success = tenant->model->Locate(request->id(), slot);
+    
+    response->set_slot(slot);
+    response->set_success(success);
+    if (!success) {
+        response->set_error_message("Memory block not found");
+    }
+    
+    return grpc::Status::OK;
+}
+
+grpc::Status MemoryManagerServiceImpl::ApplyLog(grpc::ServerContext* context, 
+                                         const mpointers::ApplyLogRequest* request,
+                                         mpointers::ApplyLogResponse* response) {
+    std::lock_guard<std::mutex> lock(roleMutex);
+    if (!follower) {
+        response->set_success(false);
+        response->set_error_message("Memory Manager is not a follower");
+        response->set_last_sequence(model->GetLogSequence());
+        return grpc::Status::OK;
+    }
+    
+    std::vector<LogRecord> records;
+    records.reserve(request->records_size());
+    for (const auto& record : request->records()) {
+        records.push_back({record.sequence(), static_cast<LogRecordType>(record.type()), record.body()});
+    }
+    
+    bool success = model->ApplyReplicatedLog(records);
+    if (!model->SyncLog()) {
+        return NotDurable();
+    }
+    
+    response->set_success(success);
+    if (!success) {
+        response->set_error_message("Records do not continue the follower's state");
+    }
+    response->set_last_sequence(model->GetLogSequence());
+    
+    // Generate memory dump after modifying memory
     view->GenerateDump();
     
     return grpc::Status::OK;
 }
 
-MemoryManagerController::MemoryManagerController(int port, size_t memorySize, const std::string& dumpFolder)
-    : port(port) {
+grpc::Status MemoryManagerServiceImpl::Promote(grpc::ServerContext* context, 
+                                        const mpointers::PromoteRequest* request,
+                                        mpointers::PromoteResponse* response) {
+    std::lock_guard<std::mutex> lock(roleMutex);
+    response->set_last_sequence(model->GetLogSequence());
+    if (!follower) {
+        response->set_success(false);
+        response->set_error_message("Memory Manager is already a primary");
+        return grpc::Status::OK;
+    }
+    
+    // Frees now come from this instance's own collector instead of the primary's records
+    follower = false;
+    model->SetReplica(false);
+    model->StartGarbageCollector();
+    std::cout << "Promoted to primary at record " << model->GetLogSequence() << std::endl;
+    
+    response->set_success(true);
+    return grpc::Status::OK;
+}
+
+MemoryManagerController::MemoryManagerController(int port, size_t memorySize, const std::string& dumpFolder,
+                                                 const std::string& socketPath, const std::string& sharedName,
+                                                 const std::string& restorePath, const std::string& walPath,
+                                                 int walIntervalMs, const std::string& replicaAddress,
+                                                 bool follower, const std::string& spillPath,
+                                                 int compressIdlePasses, int numaNode,
+                                                 const std::vector<std::pair<std::string, size_t>>& tenantSizes)
+    : port(port), socketPath(socketPath), follower(follower) {
+    
+    if (numaNode >= 0) {
+        // Every thread started from here on (collector, replicator, gRPC workers)
+        // inherits the pinning, and the arena is first touched from the node
+        PinToNumaNode(numaNode);
+    }
     
     // Create model and view
-    model = std::make_unique<MemoryManagerModel>(memorySize);
+    model = std::make_unique<MemoryManagerModel>(memorySize, sharedName, restorePath, spillPath);
+    if (numaNode >= 0 && !BindMemoryToNumaNode(model->GetMemoryPointer(), model->GetMemorySize(), numaNode)) {
+        std::cerr << "Could not bind the arena to NUMA node " << numaNode << ", relying on first touch" << std::endl;
+    }
+    model->SetReplica(follower);
+    model->SetCompression(compressIdlePasses);
+    if (!walPath.empty()) {
+        // Replay before the collector or any client can touch the state
+        model->OpenLog(walPath, walIntervalMs);
+    }
+    if (!replicaAddress.empty()) {
+        replicator = std::make_unique<LogReplicator>(replicaAddress, std::chrono::milliseconds(REPLICATION_INTERVAL_MS));
+        LogReplicator* target = replicator.get();
+        model->SetReplicationSink([target](uint64_t sequence, LogRecordType type, const std::string& body) {
+            target->Append(sequence, type, body);
+        });
+    }
     view = std::make_unique<MemoryManagerView>(model.get(), dumpFolder);
     
-    // Start garbage collector
-    model->StartGarbageCollector();
+    // Start garbage collector, a follower gets its frees from the primary until promoted
+    if (!follower) {
+        model->StartGarbageCollector();
+    }
+    
+    // Tenants get plain arenas of their own, each with its own lock and collector,
+    // so one tenant filling or fragmenting its arena never stalls the others
+    std::unordered_map<std::string, TenantArena> tenants;
+    for (const auto& tenant : tenantSizes) {
+        tenantModels.push_back(std::make_unique<MemoryManagerModel>(tenant.second));
+        MemoryManagerModel* tenantModel = tenantModels.back().get();
+        if (numaNode >= 0) {
+            BindMemoryToNumaNode(tenantModel->GetMemoryPointer(), tenantModel->GetMemorySize(), numaNode);
+        }
+        tenantModel->SetCompression(compressIdlePasses);
+        tenantViews.push_back(std::make_unique<MemoryManagerView>(tenantModel, dumpFolder + "/" + tenant.first));
+        tenantModel->StartGarbageCollector();
+        tenants[tenant.first] = TenantArena{tenantModel, tenantViews.back().get()};
+    }
     
     // Create service
-    service = std::make_unique<MemoryManagerServiceImpl>(model.get(), view.get());
+    service = std::make_unique<MemoryManagerServiceImpl>(model.get(), view.get(), follower, tenants);
 }
 
 MemoryManagerController::~MemoryManagerController() {
@@ -109,11 +675,27 @@ void MemoryManagerController::Start() {
     
     grpc::ServerBuilder builder;
     builder.AddListeningPort(serverAddress, grpc::InsecureServerCredentials());
+    
+    // Co-located clients can skip the TCP stack through the Unix socket
+    if (!socketPath.empty()) {
+        unlink(socketPath.c_str()); // Remove a stale socket left by a previous run
+        builder.AddListeningPort("unix:" + socketPath, grpc::InsecureServerCredentials());
+    }
+    if (follower) {
+        // A replicated record can carry a whole client message plus its framing
+        builder.SetMaxReceiveMessageSize(FOLLOWER_MAX_MESSAGE_BYTES);
+    }
     builder.RegisterService(service.get());
     
     // Build and start server
     server = builder.BuildAndStart();
+    if (!server) {
+        throw std::runtime_error("Failed to start gRPC server");
+    }
     std::cout << "Memory Manager listening on " << serverAddress << std::endl;
+    if (!socketPath.empty()) {
+        std::cout << "Memory Manager listening on unix:" << socketPath << std::endl;
+    }
     
     view->DisplayMemoryState();
     
@@ -124,7 +706,13 @@ void MemoryManagerController::Start() {
 void MemoryManagerController::Stop() {
     if (server) {
         server->Shutdown();
+        if (!socketPath.empty()) {
+            unlink(socketPath.c_str());
+        }
     }
     
     model->StopGarbageCollector();
+    for (auto& tenantModel : tenantModels) {
+        tenantModel->StopGarbageCollector();
+    }
 }
\ No newline at end of file
@@ -2,42 +2,131 @@
 
 #include "../Model/MemoryManagerModel.h"
 #include "../View/MemoryManagerView.h"
+#include "LogReplicator.h"
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <grpcpp/grpcpp.h>
 #include "mpointers.grpc.pb.h"
 
+// Arena and dump writer of one tenant (see TenantMetadata.h)
+struct TenantArena {
+    MemoryManagerModel* model;
+    MemoryManagerView* view;
+};
+
 class MemoryManagerServiceImpl final : public mpointers::MemoryManager::Service {
 public:
-    explicit MemoryManagerServiceImpl(MemoryManagerModel* model, MemoryManagerView* view);
+    // A follower only takes writes from its primary (ApplyLog) until it is promoted.
+    // model and view serve calls without a tenant, tenants the named ones
+    MemoryManagerServiceImpl(MemoryManagerModel* model, MemoryManagerView* view, bool follower = false,
+                             const std::unordered_map<std::string, TenantArena>& tenants = {});
     
     virtual grpc::Status Create(grpc::ServerContext* context, 
                               const mpointers::CreateRequest* request,
                               mpointers::CreateResponse* response) override;
-                              
+    
+    virtual grpc::Status RegisterType(grpc::ServerContext* context, 
+                                    const mpointers::RegisterTypeRequest* request,
+                                    mpointers::RegisterTypeResponse* response) override;
+    
+    virtual grpc::Status CreateRegion(grpc::ServerContext* context, 
+                                    const mpointers::CreateRegionRequest* request,
+                                    mpointers::CreateRegionResponse* response) override;
+    
+    virtual grpc::Status ReleaseRegion(grpc::ServerContext* context, 
+                                     const mpointers::ReleaseRegionRequest* request,
+                                     mpointers::ReleaseRegionResponse* response) override;
+    
+    virtual grpc::Status Snapshot(grpc::ServerContext* context, 
+                                const mpointers::SnapshotRequest* request,
+                                mpointers::SnapshotResponse* response) override;
+    
     virtual grpc::Status Set(grpc::ServerContext* context, 
                            const mpointers::SetRequest* request,
                            mpointers::SetResponse* response) override;
-                           
+    
     virtual grpc::Status Get(grpc::ServerContext* context, 
                            const mpointers::GetRequest* request,
                            mpointers::GetResponse* response) override;
-                           
+    
     virtual grpc::Status IncreaseRefCount(grpc::ServerContext* context, 
                                        const mpointers::RefCountRequest* request,
                                        mpointers::RefCountResponse* response) override;
-                                       
+    
     virtual grpc::Status DecreaseRefCount(grpc::ServerContext* context, 
                                        const mpointers::RefCountRequest* request,
                                        mpointers::RefCountResponse* response) override;
+    
+    virtual grpc::Status GetRange(grpc::ServerContext* context, 
+                                const mpointers::GetRangeRequest* request,
+                                mpointers::GetResponse* response) override;
+    
+    virtual grpc::Status SetRange(grpc::ServerContext* context, 
+                                const mpointers::SetRangeRequest* request,
+                                mpointers::SetResponse* response) override;
+    
+    virtual grpc::Status GetBatch(grpc::ServerContext* context, 
+                                const mpointers::GetBatchRequest* request,
+                                mpointers::GetBatchResponse* response) override;
+    
+    virtual grpc::Status Traverse(grpc::ServerContext* context, 
+                                const mpointers::TraverseRequest* request,
+                                mpointers::TraverseResponse* response) override;
+    
+    virtual grpc::Status Resize(grpc::ServerContext* context, 
+                              const mpointers::ResizeRequest* request,
+                              mpointers::ResizeResponse* response) override;
+    
+    virtual grpc::Status Atomic(grpc::ServerContext* context, 
+                              const mpointers::AtomicRequest* request,
+                              mpointers::AtomicResponse* response) override;
+    
+    virtual grpc::Status GetArenaInfo(grpc::ServerContext* context, 
+                                    const mpointers::ArenaInfoRequest* request,
+                                    mpointers::ArenaInfoResponse* response) override;
+    
+    virtual grpc::Status Locate(grpc::ServerContext* context, 
+                              const mpointers::LocateRequest* request,
+                              mpointers::LocateResponse* response) override;
+    
+    virtual grpc::Status ApplyLog(grpc::ServerContext* context, 
+                                const mpointers::ApplyLogRequest* request,
+                                mpointers::ApplyLogResponse* response) override;
+    
+    virtual grpc::Status Promote(grpc::ServerContext* context, 
+                               const mpointers::PromoteRequest* request,
+                               mpointers::PromoteResponse* response) override;
 private:
-    MemoryManagerModel* model;
+    MemoryManagerModel* model; // Default arena, the only one that is logged and replicated
     MemoryManagerView* view;
+    std::unordered_map<std::string, TenantArena> tenants; // Includes the default under ""
+    std::atomic<bool> follower;
+    std::mutex roleMutex; // Keeps a promotion from interleaving with an ApplyLog batch
+    
+    template <typename Response>
+    bool RejectOnFollower(Response* response);
+    
+    // Arena named by the call's tenant metadata, nullptr for an unknown tenant
+    const TenantArena* FindTenant(grpc::ServerContext* context) const;
+    static grpc::Status UnknownTenant();
+    // The log was closed before a change made by the call got to disk
+    static grpc::Status NotDurable();
 };
 
 class MemoryManagerController {
 public:
-    MemoryManagerController(int port, size_t memorySize, const std::string& dumpFolder);
+    MemoryManagerController(int port, size_t memorySize, const std::string& dumpFolder,
+                            const std::string& socketPath = "", const std::string& sharedName = "",
+                            const std::string& restorePath = "", const std::string& walPath = "",
+                            int walIntervalMs = 5, const std::string& replicaAddress = "",
+                            bool follower = false, const std::string& spillPath = "",
+                            int compressIdlePasses = 0, int numaNode = -1,
+                            const std::vector<std::pair<std::string, size_t>>& tenantSizes = {});
     ~MemoryManagerController();
     
     void Start();
@@ -45,8 +134,13 @@ public:
     
 private:
     int port;
+    std::string socketPath; // Optional Unix domain socket, empty when disabled
+    bool follower;
+    std::unique_ptr<LogReplicator> replicator; // Outlives the model, which feeds it
     std::unique_ptr<MemoryManagerModel> model;
     std::unique_ptr<MemoryManagerView> view;
+    std::vector<std::unique_ptr<MemoryManagerModel>> tenantModels;
+    std::vector<std::unique_ptr<MemoryManagerView>> tenantViews;
     std::unique_ptr<grpc::Server> server;
     std::unique_ptr<MemoryManagerServiceImpl> service;
 };
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "NumaPlacement.h"
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+std::vector<int> NumaNodeCpus(int node) {
+    std::vector<int> cpus;
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    if (node < 0 || !std::getline(file, list)) {
+        return cpus;
+    }
+    
+    // Comma-separated CPUs and ranges, e.g. "0-7,16-23"
+    std::stringstream ranges(list);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        if (range.empty()) {
+            continue;
+        }
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+void PinToNumaNode(int node) {
+    std::vector<int> cpus = NumaNodeCpus(node);
+    if (cpus.empty()) {
+        throw std::runtime_error("NUMA node " + std::to_string(node) + " does not exist or has no CPUs");
+    }
+    
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        throw std::runtime_error("Failed to pin to the CPUs of NUMA node " + std::to_string(node));
+    }
+}
+
+bool BindMemoryToNumaNode(const void* memory, size_t length, int node) {
+    // mbind works on whole pages, the partial pages at the edges keep the default policy
+    uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t start = (reinterpret_cast<uintptr_t>(memory) + page - 1) & ~(page - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(memory) + length) & ~(page - 1);
+    if (end <= start) {
+        return true;
+    }
+    
+    const size_t maskBits = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> mask(node / maskBits + 1, 0);
+    mask[node / maskBits] |= 1UL << (node % maskBits);
+    // Raw syscall, so mem-mgr does not need libnuma
+    return syscall(SYS_mbind, start, end - start, MPOL_BIND, mask.data(), mask.size() * maskBits + 1,
+                   MPOL_MF_MOVE) == 0;
+}
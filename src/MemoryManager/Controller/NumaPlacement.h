@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Keeps a mem-mgr on one NUMA node (--numa-node). A multi-socket host runs one
+// mem-mgr per node and clients connect to all of them, so every arena and the
+// threads serving it stay on the same socket.
+
+// CPUs of node as listed in sysfs, empty when the node does not exist
+std::vector<int> NumaNodeCpus(int node);
+
+// Restrict the calling thread, and every thread it starts afterwards, to the
+// CPUs of node. Throws std::runtime_error for an unknown node
+void PinToNumaNode(int node);
+
+// Bind the pages of [memory, memory + length) to node, moving any already
+// touched. False when the kernel refuses (no NUMA support or not permitted)
+bool BindMemoryToNumaNode(const void* memory, size_t length, int node);
@@ -0,0 +1,104 @@
+#include "BlockCodec.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_MATCH = MIN_MATCH + 127;
+constexpr size_t MAX_LITERALS = 128;
+constexpr size_t MAX_DISTANCE = 65535;
+constexpr int HASH_BITS = 12;
+
+uint32_t HashWord(const char* data) {
+    uint32_t word;
+    memcpy(&word, data, sizeof(word));
+    return (word * 2654435761u) >> (32 - HASH_BITS);
+}
+
+void EmitLiterals(std::string& out, const char* data, size_t length) {
+    while (length > 0) {
+        size_t run = std::min(length, MAX_LITERALS);
+        out.push_back(static_cast<char>(run - 1));
+        out.append(data, run);
+        data += run;
+        length -= run;
+    }
+}
+
+} // namespace
+
+std::string CompressBlockData(const char* data, size_t size) {
+    std::string out;
+    out.reserve(size / 2);
+    // Last position + 1 where each hashed 4-byte word was seen (0 for none)
+    std::vector<uint32_t> table(1u << HASH_BITS, 0);
+    
+    size_t literalStart = 0;
+    size_t position = 0;
+    while (position + MIN_MATCH <= size) {
+        uint32_t& slot = table[HashWord(data + position)];
+        size_t candidate = slot;
+        slot = static_cast<uint32_t>(position + 1);
+        
+        if (candidate == 0 || position - (candidate - 1) > MAX_DISTANCE ||
+            memcmp(data + candidate - 1, data + position, MIN_MATCH) != 0) {
+            position++;
+            continue;
+        }
+        candidate--;
+        
+        size_t length = MIN_MATCH;
+        while (position + length < size && length < MAX_MATCH && data[candidate + length] == data[position + length]) {
+            length++;
+        }
+        
+        EmitLiterals(out, data + literalStart, position - literalStart);
+        uint16_t distance = static_cast<uint16_t>(position - candidate);
+        out.push_back(static_cast<char>(0x80 | (length - MIN_MATCH)));
+        out.append(reinterpret_cast<const char*>(&distance), sizeof(distance));
+        
+        position += length;
+        literalStart = position;
+    }
+    EmitLiterals(out, data + literalStart, size - literalStart);
+    
+    return out;
+}
+
+bool DecompressBlockData(const char* data, size_t length, char* out, size_t size) {
+    size_t in = 0;
+    size_t produced = 0;
+    while (in < length) {
+        unsigned char token = static_cast<unsigned char>(data[in++]);
+        if (token & 0x80) {
+            uint16_t distance;
+            if (in + sizeof(distance) > length) {
+                return false;
+            }
+            memcpy(&distance, data + in, sizeof(distance));
+            in += sizeof(distance);
+            
+            size_t count = (token & 0x7f) + MIN_MATCH;
+            if (distance == 0 || distance > produced || count > size - produced) {
+                return false;
+            }
+            // Byte by byte, the source may overlap what is being written
+            for (size_t i = 0; i < count; ++i) {
+                out[produced + i] = out[produced + i - distance];
+            }
+            produced += count;
+        } else {
+            size_t count = token + 1;
+            if (count > length - in || count > size - produced) {
+                return false;
+            }
+            memcpy(out + produced, data + in, count);
+            in += count;
+            produced += count;
+        }
+    }
+    return produced == size;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Small LZ77-style codec for block contents. The output is a sequence of
+//
+//   [0LLLLLLL][L+1 literal bytes]        literal run of 1..128 bytes
+//   [1LLLLLLL][uint16 distance]          copy L+4 (4..131) bytes from distance back
+//
+// Copies may overlap what they produce, so a run of one repeated byte (the
+// zero padding of sparse structs and fixed strings) costs 3 bytes per 131.
+// The encoder is greedy with a single hash probe, so it is deterministic and
+// log replay reproduces the same compressed size.
+std::string CompressBlockData(const char* data, size_t size);
+
+// Decode into exactly size bytes, false on malformed input
+bool DecompressBlockData(const char* data, size_t length, char* out, size_t size);
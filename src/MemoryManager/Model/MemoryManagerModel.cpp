@@ -1,9 +1,43 @@
 #include "MemoryManagerModel.h"
+#include "Snapshot.h"
+#include "BlockCodec.h"
 #include <cstring>
 #include <iostream>
+#include <sys/mman.h>
 
-MemoryManagerModel::MemoryManagerModel(size_t memorySize) 
-    : memorySize(memorySize), nextId(1), gcRunning(false) {
+namespace {
+
+// Blocks this small are not worth compressing, from this size one idle pass is enough
+constexpr size_t MIN_COMPRESS_SIZE = 64;
+constexpr size_t LARGE_BLOCK_SIZE = 64 * 1024;
+
+// Last log record appended by this thread, SyncLog waits for it
+thread_local uint64_t lastLogSequence = 0;
+// Set while this thread applies records from a log or a primary, which are not logged again
+thread_local bool applyingLog = false;
+
+} // namespace
+
+MemoryManagerModel::MemoryManagerModel(size_t memorySize, const std::string& sharedName,
+                                       const std::string& restorePath, const std::string& spillPath) 
+    : memorySize(memorySize), memoryMapped(false), logSequence(0), accessClock(0), replica(false),
+      compressIdlePasses(0), nextId(1), nextRegionId(1), gcRunning(false) {
+    if (!spillPath.empty()) {
+        spill = std::make_unique<SpillFile>(spillPath);
+    }
+    
+    if (!restorePath.empty()) {
+        RestoreSnapshot(restorePath, sharedName);
+        return;
+    }
+    
+    if (!sharedName.empty()) {
+        // Back the arena with a shared segment that local clients can map
+        sharedArena = std::make_unique<SharedArena>(sharedName, memorySize, SHARED_SLOT_COUNT);
+        memory = sharedArena->GetArena();
+        return;
+    }
+    
     // Allocate the single large block of memory
     memory = malloc(memorySize);
     if (!memory) {
@@ -15,42 +49,393 @@ MemoryManagerModel::MemoryManagerModel(size_t memorySize)
 
 MemoryManagerModel::~MemoryManagerModel() {
     StopGarbageCollector();
-    // Free the single allocated memory block
-    free(memory);
+    // Free the single allocated memory block (a shared segment unmaps itself)
+    if (memoryMapped) {
+        munmap(memory, memorySize);
+    } else if (!sharedArena) {
+        free(memory);
+    }
 }
 
-int MemoryManagerModel::Create(size_t size, const std::string& type) {
+void MemoryManagerModel::RestoreSnapshot(const std::string& path, const std::string& sharedName) {
+    SnapshotFile snapshot(path);
+    const SnapshotContents& contents = snapshot.GetContents();
+    
+    memorySize = contents.memorySize;
+    allocatedBlocks = contents.blocks;
+    nextId = contents.nextId;
+    nextRegionId = contents.nextRegionId;
+    openRegions = contents.openRegions;
+    logSequence = contents.walSequence;
+    types = contents.types;
+    for (size_t i = 0; i < types.size(); ++i) {
+        typeIds[types[i].hash] = static_cast<int>(i + 1);
+    }
+    
+    // Spilled blocks are stored after the arena, they go back to this process's spill file
+    for (auto& block : allocatedBlocks) {
+        if (!block.spilled || !block.isAllocated) {
+            continue;
+        }
+        if (!spill) {
+            throw std::runtime_error("Snapshot " + path + " has spilled blocks, start with a spill file");
+        }
+        std::string data(block.GetStoredSize(), '\0');
+        snapshot.ReadSpilled(block.spillOffset, &data[0], data.size());
+        long long position = spill->Write(data.data(), data.size());
+        if (position < 0) {
+            throw std::runtime_error("Failed to write spill file while restoring " + path);
+        }
+        block.spillOffset = position;
+    }
+    
+    if (sharedName.empty()) {
+        // Map the arena from the file, pages are read on first touch
+        // and writes stay private to this process
+        memory = snapshot.MapArena();
+        memoryMapped = true;
+        return;
+    }
+    
+    // A shared arena has to live in the shm segment, so copy it in
+    sharedArena = std::make_unique<SharedArena>(sharedName, memorySize, SHARED_SLOT_COUNT);
+    memory = sharedArena->GetArena();
+    snapshot.ReadArena(memory);
+    for (auto& block : allocatedBlocks) {
+        if (block.isAllocated && !block.spilled && !block.compressed) {
+            block.slot = sharedArena->AcquireSlot(block.id, block.offset, block.size);
+        }
+    }
+}
+
+long long MemoryManagerModel::SaveSnapshot(const std::string& path) {
+    // The locks stay held so no record lands in the log between the
+    // snapshot and the truncation below
     std::lock_guard<std::mutex> lock(memoryMutex);
+    std::lock_guard<std::mutex> typeLock(typeMutex);
+    std::lock_guard<std::mutex> logLock(logMutex);
     
-    // Find free space in memory
-    size_t offset = FindFreeSpace(size);
-    if (offset == -1) {
-        // No space available
-        Defragment();
-        offset = FindFreeSpace(size);
-        if (offset == -1) {
-            return -1; // Still no space after defragmentation
+    SnapshotContents contents;
+    contents.memorySize = memorySize;
+    contents.blocks = allocatedBlocks;
+    contents.nextId = nextId;
+    contents.nextRegionId = nextRegionId;
+    contents.openRegions = openRegions;
+    contents.types = types;
+    contents.walSequence = logSequence;
+    
+    // Holding the lock keeps the arena consistent with the metadata while it is written
+    long long written = WriteSnapshot(path, contents, memory, spill.get());
+    if (written != -1 && wal) {
+        wal->Truncate();
+    }
+    return written;
+}
+
+void MemoryManagerModel::OpenLog(const std::string& path, int intervalMs) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    
+    // Records up to logSequence are already in the restored snapshot (a crash
+    // between a snapshot and the log truncation leaves them behind), the rest
+    // must follow on without a gap
+    uint64_t lastSequence = WriteAheadLog::Replay(path,
+        [this](uint64_t sequence, LogRecordType type, const std::string& body) {
+            if (sequence <= logSequence) {
+                return;
+            }
+            if (sequence != logSequence + 1) {
+                throw std::runtime_error("Log starts at record " + std::to_string(sequence) +
+                                         " but the state ends at record " + std::to_string(logSequence) +
+                                         ", restore the matching snapshot first");
+            }
+            ApplyLogRecord(type, body);
+            logSequence = sequence;
+        });
+    
+    wal = std::make_unique<WriteAheadLog>(path, std::max(lastSequence, logSequence),
+                                          std::chrono::milliseconds(intervalMs));
+}
+
+bool MemoryManagerModel::SyncLog() {
+    if (wal && lastLogSequence != 0) {
+        return wal->WaitDurable(lastLogSequence);
+    }
+    return true;
+}
+
+void MemoryManagerModel::SetReplicationSink(ReplicationSink sink) {
+    std::lock_guard<std::mutex> lock(logMutex);
+    replicationSink = std::move(sink);
+}
+
+bool MemoryManagerModel::ApplyReplicatedLog(const std::vector<LogRecord>& records) {
+    // One lock for the whole batch, so readers only ever see a prefix of the primary's history
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    
+    for (const auto& record : records) {
+        uint64_t sequence = GetLogSequence();
+        if (record.sequence <= sequence) {
+            continue; // Resent after a lost reply, or already in a restored snapshot
+        }
+        if (record.sequence != sequence + 1) {
+            std::cerr << "Replicated record " << record.sequence << " does not follow record " << sequence << std::endl;
+            return false;
+        }
+        
+        try {
+            ApplyLogRecord(record.type, record.body);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to apply replicated record " << record.sequence << ": " << e.what() << std::endl;
+            return false;
+        }
+        
+        std::lock_guard<std::mutex> logLock(logMutex);
+        logSequence = record.sequence;
+        if (wal) {
+            wal->Append(record.sequence, record.type, record.body);
+            lastLogSequence = record.sequence;
+        }
+        if (replicationSink) {
+            replicationSink(record.sequence, record.type, record.body); // Chained follower
+        }
+    }
+    return true;
+}
+
+uint64_t MemoryManagerModel::GetLogSequence() {
+    std::lock_guard<std::mutex> lock(logMutex);
+    return logSequence;
+}
+
+void MemoryManagerModel::SetReplica(bool replica) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    this->replica = replica;
+}
+
+void MemoryManagerModel::LogMutation(LogRecordType type, const LogRecordWriter& record) {
+    // No log while replaying or when neither a log nor a follower is attached
+    if (applyingLog || (!wal && !replicationSink)) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(logMutex);
+    uint64_t sequence = ++logSequence;
+    if (wal) {
+        wal->Append(sequence, type, record.GetData());
+        lastLogSequence = sequence;
+    }
+    if (replicationSink) {
+        replicationSink(sequence, type, record.GetData());
+    }
+}
+
+void MemoryManagerModel::ApplyLogRecord(LogRecordType type, const std::string& body) {
+    LogRecordReader record(body);
+    
+    struct ApplyingScope {
+        ApplyingScope() { applyingLog = true; }
+        ~ApplyingScope() { applyingLog = false; }
+    } applying;
+    
+    auto findBlock = [this](int64_t id) {
+        MemoryBlock* block = FindBlockById(id);
+        if (!block) {
+            throw std::runtime_error("Log record for unknown block " + std::to_string(id));
+        }
+        return block;
+    };
+    
+    switch (type) {
+        case LogRecordType::RegisterType: {
+            TypeDescriptor descriptor;
+            descriptor.name = record.GetBytes();
+            descriptor.size = record.Get<uint32_t>();
+            descriptor.alignment = record.Get<uint32_t>();
+            descriptor.hash = record.Get<uint64_t>();
+            RegisterType(descriptor);
+            break;
+        }
+        case LogRecordType::Create: {
+            MemoryBlock block;
+            block.id = record.Get<int64_t>();
+            block.offset = record.Get<uint64_t>();
+            block.size = record.Get<uint64_t>();
+            block.typeId = record.Get<int32_t>();
+            block.region = record.Get<int64_t>();
+            block.refCount = 1;
+            block.isAllocated = true;
+            block.slot = sharedArena ? sharedArena->AcquireSlot(block.id, block.offset, block.size) : -1;
+            memset(static_cast<char*>(memory) + block.offset, 0, block.size);
+            allocatedBlocks.push_back(block);
+            nextId = std::max(nextId, block.id + 1);
+            break;
+        }
+        case LogRecordType::Write: {
+            MemoryBlock* block = findBlock(record.Get<int64_t>());
+            uint64_t offset = record.Get<uint64_t>();
+            std::string value = record.GetBytes();
+            if (offset + value.size() > block->size) {
+                throw std::runtime_error("Log write past the end of block " + std::to_string(block->id));
+            }
+            WriteBlock(*block, offset, value.data(), value.size());
+            break;
+        }
+        case LogRecordType::Resize: {
+            MemoryBlock* block = findBlock(record.Get<int64_t>());
+            uint64_t offset = record.Get<uint64_t>();
+            uint64_t size = record.Get<uint64_t>();
+            MoveBlock(*block, offset, size);
+            break;
+        }
+        case LogRecordType::RefCount: {
+            MemoryBlock* block = findBlock(record.Get<int64_t>());
+            block->refCount += record.Get<int32_t>();
+            break;
+        }
+        case LogRecordType::Free:
+            FreeBlock(*findBlock(record.Get<int64_t>()));
+            break;
+        case LogRecordType::Defragment:
+            Defragment();
+            break;
+        case LogRecordType::CreateRegion: {
+            int64_t region = record.Get<int64_t>();
+            openRegions.push_back(region);
+            nextRegionId = std::max(nextRegionId, region + 1);
+            break;
+        }
+        case LogRecordType::ReleaseRegion:
+            DropRegion(record.Get<int64_t>());
+            break;
+        case LogRecordType::Spill: {
+            MemoryBlock* block = findBlock(record.Get<int64_t>());
+            if (!spill) {
+                throw std::runtime_error("Log spills block " + std::to_string(block->id) + " but there is no spill file");
+            }
+            if (!SpillBlock(*block)) {
+                throw std::runtime_error("Failed to spill block " + std::to_string(block->id));
+            }
+            break;
+        }
+        case LogRecordType::PageIn: {
+            MemoryBlock* block = findBlock(record.Get<int64_t>());
+            uint64_t offset = record.Get<uint64_t>();
+            if (!block->spilled || offset + block->GetStoredSize() > memorySize || !PageInBlock(*block, offset)) {
+                throw std::runtime_error("Failed to page in block " + std::to_string(block->id));
+            }
+            break;
+        }
+        case LogRecordType::Compress: {
+            // The codec is deterministic, so this reproduces the same compressed size
+            MemoryBlock* block = findBlock(record.Get<int64_t>());
+            if (block->spilled || block->compressed || !CompressBlock(*block)) {
+                throw std::runtime_error("Failed to compress block " + std::to_string(block->id));
+            }
+            break;
+        }
+        case LogRecordType::Expand: {
+            MemoryBlock* block = findBlock(record.Get<int64_t>());
+            uint64_t offset = record.Get<uint64_t>();
+            if (block->spilled || !block->compressed || offset + block->size > memorySize || !ExpandBlock(*block, offset)) {
+                throw std::runtime_error("Failed to decompress block " + std::to_string(block->id));
+            }
+            break;
         }
+        default:
+            throw std::runtime_error("Unknown log record type " + std::to_string(static_cast<int>(type)));
+    }
+}
+
+int MemoryManagerModel::RegisterType(const TypeDescriptor& type) {
+    std::lock_guard<std::mutex> lock(typeMutex);
+    
+    auto it = typeIds.find(type.hash);
+    if (it != typeIds.end()) {
+        TypeDescriptor& known = types[it->second - 1];
+        if (known.name != type.name) {
+            return -1; // Two names with the same hash
+        }
+        // A name-only registration learns the layout from the first client that sends it
+        if (known.size == 0 && type.size != 0) {
+            known.size = type.size;
+            known.alignment = type.alignment;
+            LogMutation(LogRecordType::RegisterType, LogRecordWriter().PutBytes(type.name.data(), type.name.size())
+                        .Put(type.size).Put(type.alignment).Put(type.hash));
+        }
+        return it->second;
+    }
+    
+    types.push_back(type);
+    int id = static_cast<int>(types.size());
+    typeIds[type.hash] = id;
+    LogMutation(LogRecordType::RegisterType, LogRecordWriter().PutBytes(type.name.data(), type.name.size())
+                .Put(type.size).Put(type.alignment).Put(type.hash));
+    return id;
+}
+
+std::string MemoryManagerModel::GetTypeName(int typeId) const {
+    std::lock_guard<std::mutex> lock(typeMutex);
+    if (typeId <= 0 || typeId > static_cast<int>(types.size())) {
+        return "unknown";
+    }
+    return types[typeId - 1].name;
+}
+
+int64_t MemoryManagerModel::Create(size_t size, const std::string& type) {
+    // Clients that still send a name get it registered without a layout
+    int typeId = RegisterType(TypeDescriptor{type, 0, 0, TypeNameHash(type)});
+    if (typeId == -1) {
+        return -1;
+    }
+    return Create(size, typeId);
+}
+
+int64_t MemoryManagerModel::Create(size_t size, int typeId, int64_t region) {
+    {
+        std::lock_guard<std::mutex> typeLock(typeMutex);
+        if (typeId <= 0 || typeId > static_cast<int>(types.size())) {
+            return -1; // Type was never registered
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    
+    if (region != 0 && std::find(openRegions.begin(), openRegions.end(), region) == openRegions.end()) {
+        return -1; // Region was never created or is already released
+    }
+    
+    // Find free space in memory, compacting or spilling cold blocks if needed
+    size_t offset = AllocateExtent(size, 0);
+    if (offset == NO_SPACE) {
+        return -1;
     }
     
+    // Space left behind by Defragment still holds old bytes, new blocks start zeroed
+    memset(static_cast<char*>(memory) + offset, 0, size);
+    
     // Create a new block
     MemoryBlock block;
     block.id = nextId++;
     block.offset = offset;
     block.size = size;
-    block.type = type;
+    block.typeId = typeId;
+    block.region = region;
     block.refCount = 1; // Initial reference count
     block.isAllocated = true;
+    block.slot = sharedArena ? sharedArena->AcquireSlot(block.id, offset, size) : -1;
+    block.lastAccess = ++accessClock;
     
     allocatedBlocks.push_back(block);
+    LogMutation(LogRecordType::Create, LogRecordWriter().Put<int64_t>(block.id).Put<uint64_t>(offset)
+                .Put<uint64_t>(size).Put<int32_t>(typeId).Put<int64_t>(region));
     return block.id;
 }
 
-bool MemoryManagerModel::Set(int id, const void* value, size_t valueSize) {
+bool MemoryManagerModel::Set(int64_t id, const void* value, size_t valueSize) {
     std::lock_guard<std::mutex> lock(memoryMutex);
     
-    MemoryBlock* block = FindBlockById(id);
-    if (!block || !block->isAllocated) {
+    MemoryBlock* block = AccessBlock(id, true);
+    if (!block) {
         return false;
     }
     
@@ -59,30 +444,204 @@ bool MemoryManagerModel::Set(int id, const void* value, size_t valueSize) {
     }
     
     // Copy the value to the memory block
-    char* dest = static_cast<char*>(memory) + block->offset;
-    memcpy(dest, value, valueSize);
+    WriteBlock(*block, 0, value, valueSize);
+    LogMutation(LogRecordType::Write, LogRecordWriter().Put<int64_t>(id).Put<uint64_t>(0).PutBytes(value, valueSize));
     
     return true;
 }
 
-bool MemoryManagerModel::Get(int id, void* value, size_t maxSize, size_t& actualSize) {
+bool MemoryManagerModel::Get(int64_t id, void* value, size_t maxSize, size_t& actualSize) {
     std::lock_guard<std::mutex> lock(memoryMutex);
     
-    MemoryBlock* block = FindBlockById(id);
-    if (!block || !block->isAllocated) {
+    MemoryBlock* block = AccessBlock(id, false);
+    if (!block) {
         return false;
     }
     
     actualSize = std::min(maxSize, block->size);
     
     // Copy from the memory block to the provided buffer
-    char* src = static_cast<char*>(memory) + block->offset;
-    memcpy(value, src, actualSize);
+    ReadBlock(*block, 0, value, actualSize);
+    
+    return true;
+}
+
+bool MemoryManagerModel::GetRange(int64_t id, size_t offset, size_t length, std::string& value) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    
+    MemoryBlock* block = AccessBlock(id, false);
+    if (!block || offset > block->size) {
+        return false;
+    }
+    
+    // Reads past the end of the block are truncated
+    size_t actualSize = std::min(length, block->size - offset);
+    value.resize(actualSize);
+    ReadBlock(*block, offset, &value[0], actualSize);
+    
+    return true;
+}
+
+bool MemoryManagerModel::SetRange(int64_t id, size_t offset, const void* value, size_t valueSize) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    
+    MemoryBlock* block = AccessBlock(id, true);
+    if (!block) {
+        return false;
+    }
+    
+    if (offset > block->size || valueSize > block->size - offset) {
+        return false; // Range does not fit in the block
+    }
+    
+    WriteBlock(*block, offset, value, valueSize);
+    LogMutation(LogRecordType::Write, LogRecordWriter().Put<int64_t>(id).Put<uint64_t>(offset)
+                .PutBytes(value, valueSize));
+    
+    return true;
+}
+
+bool MemoryManagerModel::GetBatch(const std::vector<int64_t>& ids, std::vector<std::string>& values) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    
+    values.clear();
+    values.reserve(ids.size());
+    for (int64_t id : ids) {
+        MemoryBlock* block = AccessBlock(id, false);
+        if (!block) {
+            return false;
+        }
+        
+        values.emplace_back(block->size, '\0');
+        ReadBlock(*block, 0, &values.back()[0], block->size);
+    }
+    
+    return true;
+}
+
+bool MemoryManagerModel::Traverse(int64_t startId, size_t nextOffset, int skip, int maxCount,
+                                  std::vector<std::string>& values, int64_t& nextId, int& skipped, int shard) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    
+    // Keep one response within the same 1MB that Get allows
+    const size_t MAX_RESPONSE_SIZE = 1024 * 1024;
+    
+    values.clear();
+    nextId = startId;
+    skipped = 0;
+    size_t responseSize = 0;
+    // A chain can not be longer than the number of blocks, this also stops on cycles
+    size_t hopsLeft = allocatedBlocks.size();
+    
+    while (nextId != -1 && static_cast<int>(values.size()) < maxCount && responseSize < MAX_RESPONSE_SIZE) {
+        if (shard >= 0 && ShardOfId(nextId) != shard) {
+            break; // The client continues on the server that owns the next node
+        }
+        MemoryBlock* block = AccessBlock(shard >= 0 ? LocalIdOf(nextId) : nextId, false);
+        if (!block || nextOffset + sizeof(int64_t) > block->size || hopsLeft-- == 0) {
+            return false;
+        }
+        
+        int64_t followingId;
+        ReadBlock(*block, nextOffset, &followingId, sizeof(followingId));
+        
+        if (skipped < skip) {
+            skipped++;
+        } else {
+            values.emplace_back(block->size, '\0');
+            ReadBlock(*block, 0, &values.back()[0], block->size);
+            responseSize += block->size;
+        }
+        nextId = followingId;
+    }
+    
+    return true;
+}
+
+size_t MemoryManagerModel::GetFreeMemory() {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    return FreeArenaBytes();
+}
+
+size_t MemoryManagerModel::FreeArenaBytes() const {
+    size_t used = 0;
+    for (const auto& block : allocatedBlocks) {
+        if (block.isAllocated && !block.spilled) {
+            used += block.GetStoredSize();
+        }
+    }
+    return memorySize - used;
+}
+
+bool MemoryManagerModel::Resize(int64_t id, size_t newSize) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    
+    MemoryBlock* block = AccessBlock(id, true);
+    if (!block) {
+        return false;
+    }
+    
+    // Shrinking and growing into the free extent right after the block
+    // both keep the data where it is
+    size_t offset = block->offset;
+    size_t oldSize = block->size;
+    if (newSize > oldSize && FindExtentEnd(*block) - block->offset < newSize) {
+        // Move the block (FindFreeSpace and Defragment reorder the block list,
+        // block is only valid again once it is looked up)
+        offset = FindFreeSpace(newSize);
+        if (offset == NO_SPACE && FreeArenaBytes() >= newSize - oldSize) {
+            Defragment();
+            block = FindBlockById(id);
+            if (FindExtentEnd(*block) - block->offset >= newSize) {
+                offset = block->offset; // Compaction freed the space behind it
+            } else {
+                offset = FindFreeSpace(newSize);
+            }
+        }
+        if (offset == NO_SPACE && MakeRoom(newSize, id)) {
+            offset = FindFreeSpace(newSize);
+        }
+        if (offset == NO_SPACE) {
+            return false;
+        }
+        block = FindBlockById(id);
+    }
+    
+    MoveBlock(*block, offset, newSize);
+    LogMutation(LogRecordType::Resize, LogRecordWriter().Put<int64_t>(id).Put<uint64_t>(offset).Put<uint64_t>(newSize));
     
     return true;
 }
 
-bool MemoryManagerModel::IncreaseRefCount(int id) {
+void MemoryManagerModel::MoveBlock(MemoryBlock& block, size_t offset, size_t newSize) {
+    char* base = static_cast<char*>(memory);
+    
+    if (block.slot >= 0) {
+        sharedArena->Lock(block.slot);
+    }
+    if (offset == block.offset) {
+        if (newSize > block.size) {
+            memset(base + block.offset + block.size, 0, newSize - block.size);
+        } else {
+            memset(base + block.offset + newSize, 0, block.size - newSize);
+        }
+    } else {
+        // The new extent never overlaps the old one, which is left zeroed
+        memmove(base + offset, base + block.offset, std::min(block.size, newSize));
+        if (newSize > block.size) {
+            memset(base + offset + block.size, 0, newSize - block.size);
+        }
+        memset(base + block.offset, 0, block.size);
+    }
+    block.offset = offset;
+    block.size = newSize;
+    if (block.slot >= 0) {
+        sharedArena->Move(block.slot, block.offset, block.size);
+        sharedArena->Unlock(block.slot);
+    }
+}
+
+bool MemoryManagerModel::IncreaseRefCount(int64_t id) {
     std::lock_guard<std::mutex> lock(memoryMutex);
     
     MemoryBlock* block = FindBlockById(id);
@@ -90,11 +649,15 @@ bool MemoryManagerModel::IncreaseRefCount(int id) {
         return false;
     }
     
-    block->refCount++;
+    // Region blocks live until their region is released
+    if (block->region == 0) {
+        block->refCount++;
+        LogMutation(LogRecordType::RefCount, LogRecordWriter().Put<int64_t>(id).Put<int32_t>(1));
+    }
     return true;
 }
 
-bool MemoryManagerModel::DecreaseRefCount(int id) {
+bool MemoryManagerModel::DecreaseRefCount(int64_t id) {
     std::lock_guard<std::mutex> lock(memoryMutex);
     
     MemoryBlock* block = FindBlockById(id);
@@ -102,7 +665,10 @@ bool MemoryManagerModel::DecreaseRefCount(int id) {
         return false;
     }
     
-    block->refCount--;
+    if (block->region == 0) {
+        block->refCount--;
+        LogMutation(LogRecordType::RefCount, LogRecordWriter().Put<int64_t>(id).Put<int32_t>(-1));
+    }
     // Note: We don't free blocks here - the garbage collector will handle that
     return true;
 }
@@ -125,29 +691,51 @@ void MemoryManagerModel::StopGarbageCollector() {
 
 void MemoryManagerModel::GarbageCollectorTask() {
     while (gcRunning) {
-        {
-            std::lock_guard<std::mutex> lock(memoryMutex);
-            
-            // Check for blocks with zero references
-            auto it = allocatedBlocks.begin();
-            while (it != allocatedBlocks.end()) {
-                if (it->isAllocated && it->refCount <= 0) {
-                    // Mark block as free
-                    it->isAllocated = false;
-                    // Zero out the memory
-                    char* blockStart = static_cast<char*>(memory) + it->offset;
-                    memset(blockStart, 0, it->size);
-                }
-                ++it;
-            }
-        }
+        CollectGarbage();
         
         // Sleep before next collection cycle
         std::this_thread::sleep_for(std::chrono::seconds(1));
     }
 }
 
+void MemoryManagerModel::CollectGarbage() {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    
+    // Check for blocks with zero references
+    auto it = allocatedBlocks.begin();
+    while (it != allocatedBlocks.end()) {
+        if (it->isAllocated && it->refCount <= 0) {
+            FreeBlock(*it);
+            LogMutation(LogRecordType::Free, LogRecordWriter().Put<int64_t>(it->id));
+        }
+        ++it;
+    }
+    
+    if (compressIdlePasses > 0) {
+        CompressColdBlocks();
+    }
+}
+
+void MemoryManagerModel::FreeBlock(MemoryBlock& block) {
+    // Mark block as free and withdraw it from shared-memory clients
+    block.isAllocated = false;
+    if (block.spilled) {
+        spill->Release(block.spillOffset, block.GetStoredSize());
+        return; // Holds no arena extent
+    }
+    if (block.slot >= 0) {
+        sharedArena->ReleaseSlot(block.slot);
+        block.slot = -1;
+    }
+    // Zero out the memory
+    char* blockStart = static_cast<char*>(memory) + block.offset;
+    memset(blockStart, 0, block.GetStoredSize());
+}
+
 void MemoryManagerModel::Defragment() {
+    // Compaction only depends on the block list, so replay repeats it exactly
+    LogMutation(LogRecordType::Defragment, LogRecordWriter());
+    
     // Remove unused blocks
     allocatedBlocks.erase(
         std::remove_if(allocatedBlocks.begin(), allocatedBlocks.end(),
@@ -168,19 +756,158 @@ void MemoryManagerModel::Defragment() {
     // Move blocks to eliminate gaps
     size_t currentOffset = 0;
     for (auto& block : allocatedBlocks) {
+        if (block.spilled) {
+            continue; // Holds no arena extent
+        }
         if (block.offset != currentOffset) {
-            // Move memory
+            // Move memory, shared-memory clients must not touch the block meanwhile
             char* src = static_cast<char*>(memory) + block.offset;
             char* dest = static_cast<char*>(memory) + currentOffset;
-            memmove(dest, src, block.size);
+            if (block.slot >= 0) {
+                sharedArena->Lock(block.slot);
+            }
+            memmove(dest, src, block.GetStoredSize());
             // Update offset
             block.offset = currentOffset;
+            if (block.slot >= 0) {
+                sharedArena->Move(block.slot, block.offset, block.size);
+                sharedArena->Unlock(block.slot);
+            }
+        }
+        currentOffset += block.GetStoredSize();
+    }
+}
+
+bool MemoryManagerModel::Atomic(int64_t id, size_t offset, size_t width, BlockAtomicOp op,
+                                int64_t operand, int64_t expected, int64_t& previous) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    
+    MemoryBlock* block = AccessBlock(id, true);
+    if (!block || !IsValidAtomicWord(offset, width, block->size)) {
+        return false;
+    }
+    
+    // The slot lock also orders the update against clients writing through shared memory
+    char* word = static_cast<char*>(memory) + block->offset + offset;
+    if (block->slot >= 0) {
+        sharedArena->Lock(block->slot);
+    }
+    previous = ApplyBlockAtomic(word, op, width, operand, expected);
+    if (block->slot >= 0) {
+        sharedArena->Unlock(block->slot);
+    }
+    // The log keeps the resulting word, replay does not redo the operation
+    LogMutation(LogRecordType::Write, LogRecordWriter().Put<int64_t>(id).Put<uint64_t>(offset).PutBytes(word, width));
+    
+    return true;
+}
+
+int64_t MemoryManagerModel::CreateRegion() {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    int64_t region = nextRegionId++;
+    openRegions.push_back(region);
+    LogMutation(LogRecordType::CreateRegion, LogRecordWriter().Put<int64_t>(region));
+    return region;
+}
+
+int MemoryManagerModel::ReleaseRegion(int64_t region) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    
+    int released = DropRegion(region);
+    if (released != -1) {
+        LogMutation(LogRecordType::ReleaseRegion, LogRecordWriter().Put<int64_t>(region));
+    }
+    return released;
+}
+
+int MemoryManagerModel::DropRegion(int64_t region) {
+    auto open = std::find(openRegions.begin(), openRegions.end(), region);
+    if (region == 0 || open == openRegions.end()) {
+        return -1;
+    }
+    openRegions.erase(open);
+    
+    // Drop every block of the region in one pass, their extents are free
+    // for the next Create right away (no refcounts, no GC cycle)
+    size_t before = allocatedBlocks.size();
+    allocatedBlocks.erase(
+        std::remove_if(allocatedBlocks.begin(), allocatedBlocks.end(),
+            [this, region](const MemoryBlock& block) {
+                if (block.region != region) {
+                    return false;
+                }
+                if (block.slot >= 0) {
+                    sharedArena->ReleaseSlot(block.slot);
+                }
+                if (block.spilled && block.isAllocated) {
+                    spill->Release(block.spillOffset, block.GetStoredSize());
+                }
+                return true;
+            }),
+        allocatedBlocks.end()
+    );
+    
+    return static_cast<int>(before - allocatedBlocks.size());
+}
+
+bool MemoryManagerModel::Locate(int64_t id, int& slot) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    
+    MemoryBlock* block = FindBlockById(id);
+    if (!block || !block->isAllocated) {
+        return false;
+    }
+    
+    slot = block->slot;
+    return true;
+}
+
+void MemoryManagerModel::ReadBlock(const MemoryBlock& block, size_t offset, void* dest, size_t length) {
+    if (block.spilled && !block.compressed) {
+        if (!spill->Read(block.spillOffset + offset, dest, length)) {
+            std::cerr << "Failed to read block " << block.id << " from the spill file" << std::endl;
+            memset(dest, 0, length);
+        }
+        return;
+    }
+    if (block.compressed) {
+        // Replicas, and reads that found no room to expand it
+        std::string stored(block.compressedSize, '\0');
+        if (block.spilled) {
+            spill->Read(block.spillOffset, &stored[0], stored.size());
+        } else {
+            memcpy(&stored[0], static_cast<const char*>(memory) + block.offset, stored.size());
+        }
+        std::string contents(block.size, '\0');
+        if (!DecompressBlockData(stored.data(), stored.size(), &contents[0], contents.size())) {
+            std::cerr << "Failed to decompress block " << block.id << std::endl;
         }
-        currentOffset += block.size;
+        memcpy(dest, contents.data() + offset, length);
+        return;
+    }
+    
+    const char* src = static_cast<const char*>(memory) + block.offset + offset;
+    if (block.slot >= 0) {
+        sharedArena->Lock(block.slot);
+    }
+    memcpy(dest, src, length);
+    if (block.slot >= 0) {
+        sharedArena->Unlock(block.slot);
     }
 }
 
-MemoryBlock* MemoryManagerModel::FindBlockById(int id) {
+void MemoryManagerModel::WriteBlock(const MemoryBlock& block, size_t offset, const void* src, size_t length) {
+    char* dest = static_cast<char*>(memory) + block.offset + offset;
+    if (block.slot >= 0) {
+        sharedArena->Lock(block.slot);
+    }
+    memcpy(dest, src, length);
+    if (block.slot >= 0) {
+        sharedArena->Unlock(block.slot);
+    }
+}
+
+MemoryBlock* MemoryManagerModel::FindBlockById(int64_t id) {
     for (auto& block : allocatedBlocks) {
         if (block.id == id) {
             return &block;
@@ -189,10 +916,209 @@ MemoryBlock* MemoryManagerModel::FindBlockById(int id) {
     return nullptr;
 }
 
+MemoryBlock* MemoryManagerModel::AccessBlock(int64_t id, bool writing) {
+    MemoryBlock* block = FindBlockById(id);
+    if (!block || !block->isAllocated) {
+        return nullptr;
+    }
+    
+    if (block->spilled && (writing || !replica)) {
+        // Making room reorders the block list, a compressed block comes back compressed
+        size_t offset = AllocateExtent(block->GetStoredSize(), id);
+        if (offset == NO_SPACE) {
+            return nullptr;
+        }
+        block = FindBlockById(id);
+        if (!PageInBlock(*block, offset)) {
+            return nullptr;
+        }
+        LogMutation(LogRecordType::PageIn, LogRecordWriter().Put<int64_t>(id).Put<uint64_t>(offset));
+    }
+    
+    if (block->compressed && (writing || !replica)) {
+        // Expand in place when the space behind the compressed bytes is free
+        size_t offset = block->offset;
+        if (FindExtentEnd(*block) - block->offset < block->size) {
+            offset = AllocateExtent(block->size, id);
+            block = FindBlockById(id);
+        }
+        if (offset != NO_SPACE) {
+            if (!ExpandBlock(*block, offset)) {
+                return nullptr;
+            }
+            LogMutation(LogRecordType::Expand, LogRecordWriter().Put<int64_t>(id).Put<uint64_t>(offset));
+        } else if (writing) {
+            return nullptr;
+        }
+        // With no room left a read decompresses a copy and the block stays compressed
+    }
+    
+    block->lastAccess = ++accessClock;
+    block->accessCount++;
+    return block;
+}
+
+bool MemoryManagerModel::SpillBlock(MemoryBlock& block) {
+    char* start = static_cast<char*>(memory) + block.offset;
+    long long position = spill->Write(start, block.GetStoredSize());
+    if (position < 0) {
+        std::cerr << "Failed to write block " << block.id << " to the spill file" << std::endl;
+        return false;
+    }
+    
+    if (block.slot >= 0) {
+        sharedArena->ReleaseSlot(block.slot);
+        block.slot = -1;
+    }
+    memset(start, 0, block.GetStoredSize());
+    block.spilled = true;
+    block.spillOffset = position;
+    return true;
+}
+
+bool MemoryManagerModel::PageInBlock(MemoryBlock& block, size_t offset) {
+    if (!spill->Read(block.spillOffset, static_cast<char*>(memory) + offset, block.GetStoredSize())) {
+        std::cerr << "Failed to read block " << block.id << " from the spill file" << std::endl;
+        return false;
+    }
+    
+    spill->Release(block.spillOffset, block.GetStoredSize());
+    block.spilled = false;
+    block.offset = offset;
+    if (!block.compressed) {
+        block.slot = sharedArena ? sharedArena->AcquireSlot(block.id, offset, block.size) : -1;
+    }
+    return true;
+}
+
+void MemoryManagerModel::SetCompression(int idlePasses) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    compressIdlePasses = idlePasses;
+}
+
+bool MemoryManagerModel::CompressBlock(MemoryBlock& block) {
+    char* start = static_cast<char*>(memory) + block.offset;
+    std::string packed = CompressBlockData(start, block.size);
+    if (packed.size() > block.size / 4 * 3) {
+        return false; // Not worth the cost of expanding it again
+    }
+    
+    if (block.slot >= 0) {
+        sharedArena->ReleaseSlot(block.slot);
+        block.slot = -1;
+    }
+    // The tail of the old extent is free space for the next allocation
+    memcpy(start, packed.data(), packed.size());
+    memset(start + packed.size(), 0, block.size - packed.size());
+    block.compressed = true;
+    block.compressedSize = packed.size();
+    return true;
+}
+
+bool MemoryManagerModel::ExpandBlock(MemoryBlock& block, size_t offset) {
+    char* base = static_cast<char*>(memory);
+    std::string contents(block.size, '\0');
+    if (!DecompressBlockData(base + block.offset, block.compressedSize, &contents[0], contents.size())) {
+        std::cerr << "Failed to decompress block " << block.id << std::endl;
+        return false;
+    }
+    
+    memset(base + block.offset, 0, block.compressedSize);
+    memcpy(base + offset, contents.data(), contents.size());
+    block.compressed = false;
+    block.offset = offset;
+    block.slot = sharedArena ? sharedArena->AcquireSlot(block.id, offset, block.size) : -1;
+    return true;
+}
+
+void MemoryManagerModel::CompressColdBlocks() {
+    // A block is idle for n passes when its last access is older than the
+    // clock recorded n passes ago
+    passClocks.push_back(accessClock);
+    if (passClocks.size() > static_cast<size_t>(compressIdlePasses) + 1) {
+        passClocks.pop_front();
+    }
+    if (passClocks.size() < 2) {
+        return;
+    }
+    uint64_t idleOnePass = passClocks[passClocks.size() - 2];
+    uint64_t idleAllPasses = passClocks.size() > static_cast<size_t>(compressIdlePasses) ? passClocks.front() : 0;
+    
+    for (auto& block : allocatedBlocks) {
+        if (!block.isAllocated || block.spilled || block.compressed || block.size < MIN_COMPRESS_SIZE ||
+            block.lastAccess <= block.compressTriedAt) {
+            continue; // Gone, not resident, already done or untouched since it did not compress
+        }
+        // Large blocks hold the most memory, they go after one idle pass
+        uint64_t idleSince = block.size >= LARGE_BLOCK_SIZE ? idleOnePass : idleAllPasses;
+        if (block.lastAccess > idleSince) {
+            continue;
+        }
+        
+        if (CompressBlock(block)) {
+            LogMutation(LogRecordType::Compress, LogRecordWriter().Put<int64_t>(block.id));
+        } else {
+            block.compressTriedAt = block.lastAccess;
+        }
+    }
+}
+
+size_t MemoryManagerModel::AllocateExtent(size_t size, int64_t keepId) {
+    size_t offset = FindFreeSpace(size);
+    if (offset != NO_SPACE) {
+        return offset;
+    }
+    
+    // Compaction only helps when enough bytes are free in total
+    if (FreeArenaBytes() >= size) {
+        Defragment();
+        return FindFreeSpace(size);
+    }
+    if (MakeRoom(size, keepId)) {
+        return FindFreeSpace(size);
+    }
+    return NO_SPACE;
+}
+
+bool MemoryManagerModel::MakeRoom(size_t size, int64_t keepId) {
+    if (!spill || size > memorySize) {
+        return false;
+    }
+    
+    // Spill the least recently used blocks until enough is free, then compact once
+    std::vector<MemoryBlock*> candidates;
+    for (auto& block : allocatedBlocks) {
+        if (block.isAllocated && !block.spilled && block.id != keepId) {
+            candidates.push_back(&block);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+        [](const MemoryBlock* a, const MemoryBlock* b) {
+            return a->lastAccess < b->lastAccess;
+        });
+    
+    size_t freeBytes = FreeArenaBytes();
+    for (MemoryBlock* block : candidates) {
+        if (freeBytes >= size) {
+            break;
+        }
+        if (!SpillBlock(*block)) {
+            return false;
+        }
+        LogMutation(LogRecordType::Spill, LogRecordWriter().Put<int64_t>(block->id));
+        freeBytes += block->GetStoredSize();
+    }
+    if (freeBytes < size) {
+        return false;
+    }
+    
+    Defragment();
+    return true;
+}
+
 size_t MemoryManagerModel::FindFreeSpace(size_t size) {
-    if (allocatedBlocks.empty()) {
-        // Memory is empty
-        return 0;
+    if (size > memorySize) {
+        return NO_SPACE;
     }
     
     // Sort blocks by offset
@@ -201,33 +1127,38 @@ size_t MemoryManagerModel::FindFreeSpace(size_t size) {
             return a.offset < b.offset;
         });
     
-    // Check for space before the first block
-    if (allocatedBlocks.front().offset >= size) {
-        return 0;
-    }
-    
-    // Check for space between blocks
-    for (size_t i = 0; i < allocatedBlocks.size() - 1; ++i) {
-        const auto& current = allocatedBlocks[i];
-        const auto& next = allocatedBlocks[i + 1];
-        
-        size_t endOfCurrent = current.offset + current.size;
-        size_t availableSpace = next.offset - endOfCurrent;
-        
-        if (availableSpace >= size) {
-            return endOfCurrent;
+    // First gap that fits, between the blocks that hold an arena extent
+    size_t end = 0;
+    for (const auto& block : allocatedBlocks) {
+        if (block.spilled) {
+            continue;
         }
+        // Compare gap sizes, end + size can wrap around
+        if (block.offset - end >= size) {
+            return end;
+        }
+        end = std::max(end, block.offset + block.GetStoredSize());
     }
     
     // Check for space after the last block
-    const auto& last = allocatedBlocks.back();
-    size_t endOfLast = last.offset + last.size;
-    if (memorySize - endOfLast >= size) {
-        return endOfLast;
+    if (memorySize - end >= size) {
+        return end;
     }
     
     // No suitable space found
-    return -1;
+    return NO_SPACE;
+}
+
+size_t MemoryManagerModel::FindExtentEnd(const MemoryBlock& block) const {
+    // Start of the closest block after this one (freed blocks still hold
+    // their extent until Defragment), or the end of the arena
+    size_t end = memorySize;
+    for (const auto& other : allocatedBlocks) {
+        if (!other.spilled && other.offset > block.offset && other.offset < end) {
+            end = other.offset;
+        }
+    }
+    return end;
 }
 
 size_t MemoryManagerModel::GetTypeSize(const std::string& type) {
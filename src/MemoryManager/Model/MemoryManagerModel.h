@@ -8,51 +8,212 @@
 #include <chrono>
 #include <algorithm>
 #include <string>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <deque>
+#include "SharedArena.h"
+#include "WriteAheadLog.h"
+#include "SpillFile.h"
+#include "TypeDescriptor.h"
+#include "BlockAtomics.h"
+#include "ShardedId.h"
 
 struct MemoryBlock {
-    int id;
+    int64_t id;
     size_t offset;
     size_t size;
-    std::string type;
+    int typeId; // Registered type, see MemoryManagerModel::RegisterType
+    int64_t region; // Region the block belongs to, 0 when it is refcounted
     int refCount;
     bool isAllocated;
+    int slot; // Shared-memory slot, -1 when the block is only reachable over gRPC
+    bool spilled = false; // Contents live in the spill file at spillOffset, offset is stale
+    uint64_t spillOffset = 0;
+    uint64_t lastAccess = 0; // Access clock at the last read or write, the coldest blocks spill first
+    uint32_t accessCount = 0;
+    bool compressed = false; // Stored as compressedSize bytes of BlockCodec output
+    uint64_t compressedSize = 0;
+    uint64_t compressTriedAt = 0; // lastAccess when compression last did not pay off
+    
+    // Bytes the block takes in the arena (or the spill file)
+    size_t GetStoredSize() const { return compressed ? compressedSize : size; }
 };
 
 class MemoryManagerModel {
 public:
-    MemoryManagerModel(size_t memorySize);
+    // Slots available to shared-memory clients when the arena is shared
+    static constexpr uint32_t SHARED_SLOT_COUNT = 65536;
+    
+    using ReplicationSink = std::function<void(uint64_t sequence, LogRecordType type, const std::string& body)>;
+    
+    // A non-empty sharedName backs the arena with that POSIX shm segment. A
+    // non-empty restorePath starts from that snapshot (its arena size wins).
+    // A non-empty spillPath moves the coldest blocks to that file when the
+    // arena is full and pages them back in when they are used
+    MemoryManagerModel(size_t memorySize, const std::string& sharedName = "", const std::string& restorePath = "",
+                       const std::string& spillPath = "");
     ~MemoryManagerModel();
     
-    int Create(size_t size, const std::string& type);
-    bool Set(int id, const void* value, size_t valueSize);
-    bool Get(int id, void* value, size_t maxSize, size_t& actualSize);
-    bool IncreaseRefCount(int id);
-    bool DecreaseRefCount(int id);
+    // Register a type (idempotent by hash) and return its id, -1 on a hash collision
+    int RegisterType(const TypeDescriptor& type);
+    std::string GetTypeName(int typeId) const;
+    
+    int64_t Create(size_t size, int typeId, int64_t region = 0);
+    int64_t Create(size_t size, const std::string& type);
+    bool Set(int64_t id, const void* value, size_t valueSize);
+    bool Get(int64_t id, void* value, size_t maxSize, size_t& actualSize);
+    
+    // Ranged access to part of a block (byte offset and length inside the block)
+    bool GetRange(int64_t id, size_t offset, size_t length, std::string& value);
+    bool SetRange(int64_t id, size_t offset, const void* value, size_t valueSize);
+    
+    // Read several whole blocks under a single lock
+    bool GetBatch(const std::vector<int64_t>& ids, std::vector<std::string>& values);
+    
+    // Follow the next ids stored at nextOffset inside each block, starting at startId.
+    // Skips the first skip nodes and returns up to maxCount payloads; nextId is
+    // where a follow-up call should continue (-1 at the end of the chain) and
+    // skipped how many nodes were skipped. With shard >= 0 ids are sharded
+    // (see ShardedId.h) and the walk stops at the first id of another shard
+    bool Traverse(int64_t startId, size_t nextOffset, int skip, int maxCount,
+                  std::vector<std::string>& values, int64_t& nextId, int& skipped, int shard = -1);
+    
+    // Grow or shrink a block keeping its id and contents. Grows in place when the
+    // following extent is free, otherwise the block moves inside the arena
+    bool Resize(int64_t id, size_t newSize);
+    
+    // Apply op to the aligned word of width bytes at offset, previous gets its old value
+    bool Atomic(int64_t id, size_t offset, size_t width, BlockAtomicOp op,
+                int64_t operand, int64_t expected, int64_t& previous);
+    
+    // Regions group blocks that are released together. Their blocks keep a
+    // fixed refcount, ReleaseRegion frees all of them in one pass and returns
+    // how many it freed (-1 for an unknown region)
+    int64_t CreateRegion();
+    int ReleaseRegion(int64_t region);
+    
+    // Write the arena and all metadata to path, returns the bytes written or -1.
+    // With a log open, the log is emptied once the snapshot is on disk
+    long long SaveSnapshot(const std::string& path);
+    
+    // Replay the write-ahead log at path on top of the current state, then
+    // record every later mutation there, synced in groups every intervalMs.
+    // Throws std::runtime_error when the log does not continue this state
+    void OpenLog(const std::string& path, int intervalMs);
+    
+    // Block until every mutation made by the calling thread is in the log on disk,
+    // false when the log is closed before they got there
+    bool SyncLog();
+    
+    // Hand every later mutation record to sink too, in sequence order (set before serving)
+    void SetReplicationSink(ReplicationSink sink);
+    
+    // Apply records streamed from a primary under a single lock, skipping the
+    // ones the state already has. Returns false when they do not continue it
+    bool ApplyReplicatedLog(const std::vector<LogRecord>& records);
+    uint64_t GetLogSequence();
+    
+    // A replica's layout has to follow its primary's records, so reads serve
+    // spilled blocks from the spill file instead of paging them in
+    void SetReplica(bool replica);
+    
+    // Let the collector compress blocks idle for idlePasses passes (large
+    // ones after one) when that saves a quarter of their size. 0 turns it off
+    void SetCompression(int idlePasses);
+    
+    // Shared-memory clients bypass logging, replication and access tracking
+    // and can not read spilled or compressed blocks
+    bool AllowsSharedAccess() const {
+        return !wal && !replicationSink && !spill && compressIdlePasses == 0;
+    }
+    
+    // Shared-memory slot of a block (-1 if it has none)
+    bool Locate(int64_t id, int& slot);
+    bool IncreaseRefCount(int64_t id);
+    bool DecreaseRefCount(int64_t id);
+    
+    // Arena bytes not covered by an allocated block
+    size_t GetFreeMemory();
     
     // For the view to access
     const void* GetMemoryPointer() const { return memory; }
     size_t GetMemorySize() const { return memorySize; }
     const std::vector<MemoryBlock>& GetAllocatedBlocks() const { return allocatedBlocks; }
+    const SharedArena* GetSharedArena() const { return sharedArena.get(); }
     
     // Start garbage collector in a separate thread
     void StartGarbageCollector();
     void StopGarbageCollector();
     
+    // One collector pass (free unreferenced blocks, compress cold ones) right now
+    void CollectGarbage();
+    
     // Memory defragmentation
     void Defragment();
-
+    
 private:
     void* memory;
     size_t memorySize;
     std::vector<MemoryBlock> allocatedBlocks;
     std::mutex memoryMutex;
+    std::unique_ptr<SharedArena> sharedArena;
+    bool memoryMapped; // Arena is a private mapping of a snapshot file
+    std::unique_ptr<WriteAheadLog> wal;
+    ReplicationSink replicationSink;
+    std::mutex logMutex; // Numbers records and keeps the log and the sink in the same order
+    uint64_t logSequence; // Last mutation record reflected in the state
+    std::unique_ptr<SpillFile> spill;
+    uint64_t accessClock;
+    bool replica;
+    int compressIdlePasses;
+    std::deque<uint64_t> passClocks; // Access clock after each recent collector pass
+    
+    // Registered types, the id of types[i] is i + 1
+    std::vector<TypeDescriptor> types;
+    std::unordered_map<uint64_t, int> typeIds; // hash -> id
+    mutable std::mutex typeMutex;
     
-    int nextId;
+    int64_t nextId;
+    int64_t nextRegionId;
+    std::vector<int64_t> openRegions;
     bool gcRunning;
     std::thread gcThread;
     
     void GarbageCollectorTask();
-    MemoryBlock* FindBlockById(int id);
+    void RestoreSnapshot(const std::string& path, const std::string& sharedName);
+    MemoryBlock* FindBlockById(int64_t id);
+    
+    // Allocated block whose contents can be accessed, paged in from the spill
+    // file first unless this is a replica reading it. Counts as an access
+    MemoryBlock* AccessBlock(int64_t id, bool writing);
+    
+    // Mutations shared by the live operations and log replay
+    void LogMutation(LogRecordType type, const LogRecordWriter& record);
+    void ApplyLogRecord(LogRecordType type, const std::string& body);
+    void MoveBlock(MemoryBlock& block, size_t offset, size_t newSize);
+    void FreeBlock(MemoryBlock& block);
+    int DropRegion(int64_t region);
+    bool SpillBlock(MemoryBlock& block);
+    bool PageInBlock(MemoryBlock& block, size_t offset);
+    bool CompressBlock(MemoryBlock& block);
+    bool ExpandBlock(MemoryBlock& block, size_t offset);
+    void CompressColdBlocks();
+    
+    // FindFreeSpace and AllocateExtent result when nothing fits
+    static constexpr size_t NO_SPACE = static_cast<size_t>(-1);
+    
+    // Arena offset for size bytes: compacts when enough is free in total,
+    // otherwise spills the coldest blocks (never keepId) first. NO_SPACE when full
+    size_t AllocateExtent(size_t size, int64_t keepId);
+    bool MakeRoom(size_t size, int64_t keepId);
+    size_t FreeArenaBytes() const;
+    
+    // All copies in and out of a block go through these so shared-memory
+    // clients never observe a half-written block. Reads also serve spilled blocks
+    void ReadBlock(const MemoryBlock& block, size_t offset, void* dest, size_t length);
+    void WriteBlock(const MemoryBlock& block, size_t offset, const void* src, size_t length);
     size_t FindFreeSpace(size_t size);
+    size_t FindExtentEnd(const MemoryBlock& block) const;
     size_t GetTypeSize(const std::string& type);
 };
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "SharedArena.h"
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+SharedArena::SharedArena(const std::string& name, size_t arenaSize, uint32_t slotCount)
+    : name(name), segment(nullptr), arena(nullptr), slots(nullptr) {
+    size_t arenaOffset = SharedArenaOffset(slotCount);
+    segmentSize = arenaOffset + arenaSize;
+    
+    // Start from a fresh segment, a previous run may have left one behind
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create shared memory segment " + name);
+    }
+    
+    if (ftruncate(fd, segmentSize) != 0) {
+        close(fd);
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Failed to size shared memory segment " + name);
+    }
+    
+    segment = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Failed to map shared memory segment " + name);
+    }
+    
+    // ftruncate zero-fills the segment, so slots start free and unlocked
+    SharedArenaHeader* header = static_cast<SharedArenaHeader*>(segment);
+    header->magic = SHARED_ARENA_MAGIC;
+    header->version = SHARED_ARENA_VERSION;
+    header->slotCount = slotCount;
+    header->arenaOffset = arenaOffset;
+    header->arenaSize = arenaSize;
+    
+    slots = SharedSlots(segment);
+    arena = static_cast<char*>(segment) + arenaOffset;
+    
+    freeSlots.reserve(slotCount);
+    for (int slot = static_cast<int>(slotCount) - 1; slot >= 0; --slot) {
+        freeSlots.push_back(slot);
+    }
+}
+
+SharedArena::~SharedArena() {
+    munmap(segment, segmentSize);
+    shm_unlink(name.c_str());
+}
+
+int SharedArena::AcquireSlot(int64_t id, size_t offset, size_t size) {
+    if (freeSlots.empty()) {
+        return -1; // The block is still served over gRPC
+    }
+    
+    int slot = freeSlots.back();
+    freeSlots.pop_back();
+    
+    Lock(slot);
+    slots[slot].offset.store(offset, std::memory_order_relaxed);
+    slots[slot].size.store(size, std::memory_order_relaxed);
+    slots[slot].id.store(id, std::memory_order_relaxed);
+    Unlock(slot);
+    
+    return slot;
+}
+
+void SharedArena::ReleaseSlot(int slot) {
+    Lock(slot);
+    slots[slot].id.store(0, std::memory_order_relaxed);
+    Unlock(slot);
+    freeSlots.push_back(slot);
+}
+
+void SharedArena::Lock(int slot) {
+    LockSharedSlot(slots[slot]);
+}
+
+void SharedArena::Unlock(int slot) {
+    UnlockSharedSlot(slots[slot]);
+}
+
+void SharedArena::Move(int slot, size_t newOffset, size_t newSize) {
+    // Caller holds the slot
+    slots[slot].offset.store(newOffset, std::memory_order_relaxed);
+    slots[slot].size.store(newSize, std::memory_order_relaxed);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "SharedArenaLayout.h"
+#include <string>
+#include <vector>
+
+// POSIX shared-memory segment that backs the arena when mem-mgr runs with
+// --shm, so clients on the same host can map it and access blocks directly.
+class SharedArena {
+public:
+    SharedArena(const std::string& name, size_t arenaSize, uint32_t slotCount);
+    ~SharedArena();
+    
+    SharedArena(const SharedArena&) = delete;
+    SharedArena& operator=(const SharedArena&) = delete;
+    
+    void* GetArena() const { return arena; }
+    const std::string& GetName() const { return name; }
+    size_t GetSegmentSize() const { return segmentSize; }
+    
+    // Publish a block in a free slot, returns -1 when the table is full
+    int AcquireSlot(int64_t id, size_t offset, size_t size);
+    void ReleaseSlot(int slot);
+    
+    // Writers bracket every access to the bytes of a published block
+    void Lock(int slot);
+    void Unlock(int slot);
+    void Move(int slot, size_t newOffset, size_t newSize);
+    
+private:
+    std::string name;
+    size_t segmentSize;
+    void* segment;
+    void* arena;
+    SharedBlockSlot* slots;
+    std::vector<int> freeSlots;
+};
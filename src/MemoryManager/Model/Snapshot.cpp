@@ -0,0 +1,271 @@
+#include "Snapshot.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t SNAPSHOT_MAGIC = 0x4d50534e41505348ULL;
+constexpr uint32_t SNAPSHOT_VERSION = 5;
+// SnapshotBlock flags
+constexpr int32_t SNAPSHOT_BLOCK_ALLOCATED = 1;
+constexpr int32_t SNAPSHOT_BLOCK_SPILLED = 2;
+constexpr int32_t SNAPSHOT_BLOCK_COMPRESSED = 4;
+// Size of each write and read of the arena
+constexpr size_t SNAPSHOT_IO_CHUNK = 8 * 1024 * 1024;
+
+struct SnapshotHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t memorySize;
+    uint64_t arenaOffset;
+    uint64_t blockCount;
+    uint64_t typeCount;
+    uint64_t regionCount;
+    int64_t nextId;
+    int64_t nextRegionId;
+    uint64_t walSequence;
+};
+
+struct SnapshotBlock {
+    int64_t id;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t storedSize; // Bytes the block occupies, less than size when compressed
+    int64_t region;
+    int32_t typeId;
+    int32_t refCount;
+    int32_t flags;
+    int32_t reserved;
+};
+
+struct SnapshotType {
+    uint32_t nameLength;
+    uint32_t size;
+    uint32_t alignment;
+    uint32_t reserved;
+    uint64_t hash;
+};
+
+template <typename T>
+void Append(std::string& buffer, const T& value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T Take(const std::string& buffer, size_t& position) {
+    if (position + sizeof(T) > buffer.size()) {
+        throw std::runtime_error("Truncated snapshot metadata");
+    }
+    T value;
+    memcpy(&value, buffer.data() + position, sizeof(T));
+    position += sizeof(T);
+    return value;
+}
+
+bool WriteAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, std::min(length, SNAPSHOT_IO_CHUNK));
+        if (written < 0) {
+            return false;
+        }
+        data += written;
+        length -= written;
+    }
+    return true;
+}
+
+bool ReadAll(int fd, char* data, size_t length, off_t offset) {
+    while (length > 0) {
+        ssize_t got = pread(fd, data, std::min(length, SNAPSHOT_IO_CHUNK), offset);
+        if (got <= 0) {
+            return false;
+        }
+        data += got;
+        offset += got;
+        length -= got;
+    }
+    return true;
+}
+
+size_t PageAlign(size_t size) {
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return (size + page - 1) / page * page;
+}
+
+} // namespace
+
+long long WriteSnapshot(const std::string& path, const SnapshotContents& contents, const void* arena,
+                        const SpillFile* spill) {
+    // Metadata goes out in one buffer, padded so the arena lands on a page boundary
+    std::string metadata;
+    SnapshotHeader header{};
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.memorySize = contents.memorySize;
+    header.blockCount = contents.blocks.size();
+    header.typeCount = contents.types.size();
+    header.regionCount = contents.openRegions.size();
+    header.nextId = contents.nextId;
+    header.nextRegionId = contents.nextRegionId;
+    header.walSequence = contents.walSequence;
+    Append(metadata, header);
+    
+    // Spilled blocks are laid out one after another behind the arena
+    uint64_t spilledSize = 0;
+    for (const auto& block : contents.blocks) {
+        int32_t flags = (block.isAllocated ? SNAPSHOT_BLOCK_ALLOCATED : 0) |
+                        (block.spilled ? SNAPSHOT_BLOCK_SPILLED : 0) |
+                        (block.compressed ? SNAPSHOT_BLOCK_COMPRESSED : 0);
+        uint64_t offset = block.offset;
+        if (block.spilled && block.isAllocated) {
+            offset = spilledSize;
+            spilledSize += block.GetStoredSize();
+        }
+        SnapshotBlock record{block.id, offset, block.size, block.GetStoredSize(), block.region, block.typeId,
+                             block.refCount, flags, 0};
+        Append(metadata, record);
+    }
+    for (const auto& type : contents.types) {
+        SnapshotType record{static_cast<uint32_t>(type.name.size()), type.size, type.alignment, 0, type.hash};
+        Append(metadata, record);
+        metadata += type.name;
+    }
+    for (int64_t region : contents.openRegions) {
+        Append(metadata, region);
+    }
+    
+    header.arenaOffset = PageAlign(metadata.size());
+    memcpy(&metadata[0], &header, sizeof(header));
+    metadata.resize(header.arenaOffset, '\0');
+    
+    // Write next to the target and rename, a crash never leaves a torn snapshot
+    std::string temporaryPath = path + ".tmp";
+    int fd = open(temporaryPath.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0600);
+    if (fd < 0) {
+        return -1;
+    }
+    
+    bool written = WriteAll(fd, metadata.data(), metadata.size()) &&
+                   WriteAll(fd, static_cast<const char*>(arena), contents.memorySize);
+    std::string buffer;
+    for (const auto& block : contents.blocks) {
+        if (!written || !block.spilled || !block.isAllocated) {
+            continue;
+        }
+        buffer.resize(block.GetStoredSize());
+        written = spill && spill->Read(block.spillOffset, &buffer[0], buffer.size()) &&
+                  WriteAll(fd, buffer.data(), buffer.size());
+    }
+    written = written && fsync(fd) == 0;
+    close(fd);
+    if (!written || rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        unlink(temporaryPath.c_str());
+        return -1;
+    }
+    
+    return static_cast<long long>(metadata.size() + contents.memorySize + spilledSize);
+}
+
+SnapshotFile::SnapshotFile(const std::string& path) : path(path), fd(-1), arenaOffset(0) {
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open snapshot " + path);
+    }
+    
+    SnapshotHeader header;
+    if (!ReadAll(fd, reinterpret_cast<char*>(&header), sizeof(header), 0) ||
+        header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION) {
+        close(fd);
+        throw std::runtime_error("Not a snapshot file: " + path);
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<uint64_t>(info.st_size) < header.arenaOffset + header.memorySize) {
+        close(fd);
+        throw std::runtime_error("Truncated snapshot " + path);
+    }
+    
+    std::string metadata(header.arenaOffset, '\0');
+    if (!ReadAll(fd, &metadata[0], metadata.size(), 0)) {
+        close(fd);
+        throw std::runtime_error("Failed to read snapshot " + path);
+    }
+    
+    try {
+        size_t position = sizeof(header);
+        for (uint64_t i = 0; i < header.blockCount; ++i) {
+            SnapshotBlock record = Take<SnapshotBlock>(metadata, position);
+            MemoryBlock block;
+            block.id = record.id;
+            block.offset = record.offset;
+            block.size = record.size;
+            block.typeId = record.typeId;
+            block.refCount = record.refCount;
+            block.region = record.region;
+            block.isAllocated = (record.flags & SNAPSHOT_BLOCK_ALLOCATED) != 0;
+            block.slot = -1;
+            if (record.flags & SNAPSHOT_BLOCK_SPILLED) {
+                block.spilled = true;
+                block.spillOffset = record.offset;
+            }
+            if (record.flags & SNAPSHOT_BLOCK_COMPRESSED) {
+                block.compressed = true;
+                block.compressedSize = record.storedSize;
+            }
+            contents.blocks.push_back(block);
+        }
+        for (uint64_t i = 0; i < header.typeCount; ++i) {
+            SnapshotType record = Take<SnapshotType>(metadata, position);
+            if (position + record.nameLength > metadata.size()) {
+                throw std::runtime_error("Truncated snapshot metadata");
+            }
+            contents.types.push_back(TypeDescriptor{metadata.substr(position, record.nameLength),
+                                                    record.size, record.alignment, record.hash});
+            position += record.nameLength;
+        }
+        for (uint64_t i = 0; i < header.regionCount; ++i) {
+            contents.openRegions.push_back(Take<int64_t>(metadata, position));
+        }
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    
+    arenaOffset = header.arenaOffset;
+    contents.memorySize = header.memorySize;
+    contents.nextId = header.nextId;
+    contents.nextRegionId = header.nextRegionId;
+    contents.walSequence = header.walSequence;
+}
+
+SnapshotFile::~SnapshotFile() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+void* SnapshotFile::MapArena() const {
+    void* arena = mmap(nullptr, contents.memorySize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, arenaOffset);
+    if (arena == MAP_FAILED) {
+        throw std::runtime_error("Failed to map snapshot " + path);
+    }
+    return arena;
+}
+
+void SnapshotFile::ReadArena(void* dest) const {
+    if (!ReadAll(fd, static_cast<char*>(dest), contents.memorySize, arenaOffset)) {
+        throw std::runtime_error("Failed to read snapshot " + path);
+    }
+}
+
+void SnapshotFile::ReadSpilled(uint64_t offset, void* dest, size_t length) const {
+    if (!ReadAll(fd, static_cast<char*>(dest), length, arenaOffset + contents.memorySize + offset)) {
+        throw std::runtime_error("Failed to read snapshot " + path);
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "MemoryManagerModel.h"
+#include <string>
+#include <vector>
+
+// On-disk snapshot of the arena and its metadata:
+//
+//   [SnapshotHeader][blocks][types][open regions][padding][arena bytes][spilled blocks]
+//
+// The arena starts on a page boundary so a restore can mmap it straight
+// from the file instead of reading it. Blocks in the spill file follow it,
+// their spillOffset counts from the end of the arena.
+struct SnapshotContents {
+    size_t memorySize = 0;
+    int64_t nextId = 1;
+    int64_t nextRegionId = 1;
+    std::vector<MemoryBlock> blocks;
+    std::vector<TypeDescriptor> types;
+    std::vector<int64_t> openRegions;
+    uint64_t walSequence = 0; // Last write-ahead log record the snapshot includes
+};
+
+// Writes contents and the arena with large sequential writes to a temporary
+// file, syncs it and renames it over path. Returns the bytes written, -1 on error.
+// Spilled blocks are copied in from spill
+long long WriteSnapshot(const std::string& path, const SnapshotContents& contents, const void* arena,
+                        const SpillFile* spill = nullptr);
+
+class SnapshotFile {
+public:
+    // Reads the header and metadata, throws std::runtime_error on a bad file
+    explicit SnapshotFile(const std::string& path);
+    ~SnapshotFile();
+    
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+    
+    const SnapshotContents& GetContents() const { return contents; }
+    
+    // Private copy-on-write mapping of the arena, pages load on first touch.
+    // The caller owns the mapping (munmap with the memory size)
+    void* MapArena() const;
+    
+    // Copy the arena into dest with large sequential reads
+    void ReadArena(void* dest) const;
+    
+    // Contents of a spilled block, offset is its spillOffset in the snapshot
+    void ReadSpilled(uint64_t offset, void* dest, size_t length) const;
+    
+private:
+    std::string path;
+    int fd;
+    size_t arenaOffset;
+    SnapshotContents contents;
+};
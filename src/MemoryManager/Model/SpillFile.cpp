@@ -0,0 +1,97 @@
+#include "SpillFile.h"
+#include <iterator>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+SpillFile::SpillFile(const std::string& path) : path(path), fileSize(0) {
+    fd = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open spill file " + path);
+    }
+}
+
+SpillFile::~SpillFile() {
+    close(fd);
+    unlink(path.c_str());
+}
+
+long long SpillFile::Write(const void* data, size_t length) {
+    // First free extent that fits, otherwise the end of the file
+    uint64_t offset = fileSize;
+    auto fit = freeExtents.end();
+    for (auto it = freeExtents.begin(); it != freeExtents.end(); ++it) {
+        if (it->second >= length) {
+            fit = it;
+            offset = it->first;
+            break;
+        }
+    }
+    
+    const char* src = static_cast<const char*>(data);
+    size_t remaining = length;
+    while (remaining > 0) {
+        ssize_t written = pwrite(fd, src, remaining, offset + (length - remaining));
+        if (written <= 0) {
+            return -1;
+        }
+        src += written;
+        remaining -= written;
+    }
+    
+    if (fit != freeExtents.end()) {
+        uint64_t left = fit->second - length;
+        freeExtents.erase(fit);
+        if (left > 0) {
+            freeExtents[offset + length] = left;
+        }
+    } else {
+        fileSize += length;
+    }
+    return static_cast<long long>(offset);
+}
+
+bool SpillFile::Read(uint64_t offset, void* dest, size_t length) const {
+    char* out = static_cast<char*>(dest);
+    while (length > 0) {
+        ssize_t got = pread(fd, out, length, offset);
+        if (got <= 0) {
+            return false;
+        }
+        out += got;
+        offset += got;
+        length -= got;
+    }
+    return true;
+}
+
+void SpillFile::Release(uint64_t offset, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    
+    // Merge with the free extents on either side
+    auto next = freeExtents.lower_bound(offset);
+    if (next != freeExtents.end() && next->first == offset + length) {
+        length += next->second;
+        next = freeExtents.erase(next);
+    }
+    if (next != freeExtents.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            length += previous->second;
+            freeExtents.erase(previous);
+        }
+    }
+    
+    // Space at the end of the file is handed out again by growing from there
+    if (offset + length == fileSize) {
+        fileSize = offset;
+        if (ftruncate(fd, fileSize) != 0) {
+            return; // Only costs disk space
+        }
+    } else {
+        freeExtents[offset] = length;
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+// Local backing file for blocks evicted from the arena. Released extents are
+// reused first fit (adjacent ones merge), the file only grows when none fits.
+// Its contents only make sense to the running process (snapshots copy the
+// spilled blocks), so it is truncated on open and removed by the destructor.
+// Not thread safe, the model calls it under its lock
+class SpillFile {
+public:
+    // Creates or truncates path, throws std::runtime_error if it can not
+    explicit SpillFile(const std::string& path);
+    ~SpillFile();
+    
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+    
+    // Store length bytes and return their offset in the file, -1 on an I/O error
+    long long Write(const void* data, size_t length);
+    bool Read(uint64_t offset, void* dest, size_t length) const;
+    void Release(uint64_t offset, size_t length);
+    
+private:
+    std::string path;
+    int fd;
+    uint64_t fileSize;
+    std::map<uint64_t, uint64_t> freeExtents; // offset -> length
+};
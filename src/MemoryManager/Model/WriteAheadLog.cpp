@@ -0,0 +1,212 @@
+#include "WriteAheadLog.h"
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// Flush early once this much is buffered instead of waiting for the interval
+constexpr size_t LOG_BATCH_BYTES = 1024 * 1024;
+// Sequence and type in front of the body
+constexpr size_t LOG_RECORD_PREFIX = sizeof(uint64_t) + sizeof(uint8_t);
+
+uint32_t Checksum(const char* data, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+} // namespace
+
+uint64_t WriteAheadLog::Replay(const std::string& path, const ReplayFunction& apply) {
+    int fd = open(path.c_str(), O_RDWR);
+    if (fd < 0) {
+        return 0; // No log yet
+    }
+    
+    std::string contents;
+    char buffer[1 << 16];
+    ssize_t got;
+    while ((got = read(fd, buffer, sizeof(buffer))) > 0) {
+        contents.append(buffer, got);
+    }
+    
+    uint64_t lastSequence = 0;
+    size_t position = 0;
+    while (contents.size() - position >= 2 * sizeof(uint32_t)) {
+        uint32_t length;
+        uint32_t checksum;
+        memcpy(&length, contents.data() + position, sizeof(length));
+        memcpy(&checksum, contents.data() + position + sizeof(length), sizeof(checksum));
+        
+        size_t start = position + 2 * sizeof(uint32_t);
+        if (length < LOG_RECORD_PREFIX || length > contents.size() - start ||
+            Checksum(contents.data() + start, length) != checksum) {
+            break; // Torn or corrupt tail
+        }
+        
+        uint64_t sequence;
+        memcpy(&sequence, contents.data() + start, sizeof(sequence));
+        LogRecordType type = static_cast<LogRecordType>(contents[start + sizeof(sequence)]);
+        try {
+            apply(sequence, type, contents.substr(start + LOG_RECORD_PREFIX, length - LOG_RECORD_PREFIX));
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        
+        lastSequence = sequence;
+        position = start + length;
+    }
+    
+    if (position < contents.size()) {
+        std::cerr << "Discarding " << (contents.size() - position) << " bytes of incomplete log at the end of "
+                  << path << std::endl;
+        if (ftruncate(fd, position) != 0) {
+            std::cerr << "Failed to truncate log " << path << std::endl;
+        }
+    }
+    close(fd);
+    
+    return lastSequence;
+}
+
+WriteAheadLog::WriteAheadLog(const std::string& path, uint64_t lastSequence, std::chrono::microseconds interval)
+    : path(path), interval(interval), lastSequence(lastSequence), durableSequence(lastSequence),
+      durableSize(0), torn(false), flushing(false), stopping(false), closed(false) {
+    fd = open(path.c_str(), O_CREAT | O_WRONLY | O_APPEND, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open log " + path);
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size < 0) {
+        close(fd);
+        throw std::runtime_error("Failed to open log " + path);
+    }
+    durableSize = static_cast<uint64_t>(size);
+    flushThread = std::thread(&WriteAheadLog::FlushTask, this);
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    flushNeeded.notify_one();
+    flushThread.join();
+    close(fd);
+}
+
+void WriteAheadLog::Append(uint64_t sequence, LogRecordType type, const std::string& body) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    lastSequence = sequence;
+    uint32_t length = static_cast<uint32_t>(LOG_RECORD_PREFIX + body.size());
+    
+    size_t start = pending.size();
+    pending.append(2 * sizeof(uint32_t), '\0');
+    pending.append(reinterpret_cast<const char*>(&sequence), sizeof(sequence));
+    pending.push_back(static_cast<char>(type));
+    pending.append(body);
+    
+    uint32_t checksum = Checksum(pending.data() + start + 2 * sizeof(uint32_t), length);
+    memcpy(&pending[start], &length, sizeof(length));
+    memcpy(&pending[start + sizeof(length)], &checksum, sizeof(checksum));
+    
+    if (pending.size() >= LOG_BATCH_BYTES) {
+        flushNeeded.notify_one();
+    }
+}
+
+bool WriteAheadLog::WaitDurable(uint64_t sequence) {
+    std::unique_lock<std::mutex> lock(mutex);
+    flushed.wait(lock, [this, sequence]() { return durableSequence >= sequence || closed; });
+    return durableSequence >= sequence;
+}
+
+void WriteAheadLog::Truncate() {
+    std::unique_lock<std::mutex> lock(mutex);
+    // A batch being written now would land after the truncation
+    flushed.wait(lock, [this]() { return !flushing; });
+    pending.clear();
+    durableSize = 0;
+    torn = ftruncate(fd, 0) != 0;
+    if (torn) {
+        std::cerr << "Failed to truncate log " << path << std::endl;
+    }
+    // Everything appended so far is covered by the snapshot
+    durableSequence = lastSequence;
+    flushed.notify_all();
+}
+
+void WriteAheadLog::FlushTask() {
+    std::unique_lock<std::mutex> lock(mutex);
+    bool failing = false;
+    while (true) {
+        // Let a batch build up for one interval unless it is already large
+        flushNeeded.wait_for(lock, interval, [this]() { return stopping || pending.size() >= LOG_BATCH_BYTES; });
+        if (pending.empty()) {
+            if (stopping) {
+                break;
+            }
+            continue;
+        }
+        
+        std::string batch;
+        batch.swap(pending);
+        uint64_t batchSequence = lastSequence;
+        
+        // Appends keep going while the batch is written and synced
+        flushing = true;
+        bool cutBack = torn;
+        uint64_t goodSize = durableSize;
+        lock.unlock();
+        // Drop what a failed batch left behind, later records must not follow it
+        bool ok = !cutBack || ftruncate(fd, goodSize) == 0;
+        const char* data = batch.data();
+        size_t remaining = batch.size();
+        while (remaining > 0 && ok) {
+            ssize_t written = write(fd, data, remaining);
+            ok = written > 0;
+            if (ok) {
+                data += written;
+                remaining -= written;
+            }
+        }
+        ok = ok && fdatasync(fd) == 0;
+        lock.lock();
+        flushing = false;
+        
+        if (!ok) {
+            // Not durable: put the batch back in front of what came in meanwhile
+            torn = true;
+            pending.insert(0, batch);
+            if (stopping) {
+                std::cerr << "Failed to write log " << path << ", dropping records after "
+                          << durableSequence << std::endl;
+                torn = ftruncate(fd, goodSize) != 0;
+                break;
+            }
+            if (!failing) {
+                std::cerr << "Failed to write log " << path << ", retrying" << std::endl;
+            }
+            failing = true;
+            flushNeeded.wait_for(lock, interval, [this]() { return stopping; });
+            continue;
+        }
+        if (failing) {
+            std::cerr << "Log " << path << " is writable again" << std::endl;
+        }
+        failing = false;
+        torn = false;
+        durableSize = goodSize + batch.size();
+        durableSequence = std::max(durableSequence, batchSequence);
+        flushed.notify_all();
+    }
+    
+    closed = true;
+    flushed.notify_all();
+}
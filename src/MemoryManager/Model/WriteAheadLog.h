@@ -0,0 +1,142 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+// Kinds of mutation recorded in the log. Records carry the physical outcome
+// (ids, offsets) so replay does not depend on allocation or GC timing
+enum class LogRecordType : uint8_t {
+    RegisterType = 1,
+    Create = 2,
+    Write = 3,
+    Resize = 4,
+    RefCount = 5,
+    Free = 6,
+    Defragment = 7,
+    CreateRegion = 8,
+    ReleaseRegion = 9,
+    Spill = 10,
+    PageIn = 11,
+    Compress = 12,
+    Expand = 13
+};
+
+// Builds the body of a record
+class LogRecordWriter {
+public:
+    template <typename T>
+    LogRecordWriter& Put(const T& value) {
+        data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        return *this;
+    }
+    
+    LogRecordWriter& PutBytes(const void* bytes, size_t length) {
+        Put(static_cast<uint64_t>(length));
+        data.append(static_cast<const char*>(bytes), length);
+        return *this;
+    }
+    
+    const std::string& GetData() const { return data; }
+    
+private:
+    std::string data;
+};
+
+// Reads the body of a record, throws std::runtime_error past its end
+class LogRecordReader {
+public:
+    explicit LogRecordReader(const std::string& data) : data(data), position(0) {}
+    
+    template <typename T>
+    T Get() {
+        if (position + sizeof(T) > data.size()) {
+            throw std::runtime_error("Truncated log record");
+        }
+        T value;
+        memcpy(&value, data.data() + position, sizeof(T));
+        position += sizeof(T);
+        return value;
+    }
+    
+    std::string GetBytes() {
+        uint64_t length = Get<uint64_t>();
+        if (length > data.size() - position) {
+            throw std::runtime_error("Truncated log record");
+        }
+        std::string bytes = data.substr(position, length);
+        position += length;
+        return bytes;
+    }
+    
+private:
+    const std::string& data;
+    size_t position;
+};
+
+// A numbered record, as streamed to a follower
+struct LogRecord {
+    uint64_t sequence;
+    LogRecordType type;
+    std::string body;
+};
+
+// Append-only log with group commit. Append only buffers the record, a
+// flush thread writes everything buffered with one write and one fdatasync
+// per interval (or sooner once a batch grows large), and WaitDurable blocks
+// a caller until its record is on disk. A batch that fails to write or sync
+// is cut off the file again and retried, so records are only ever reported
+// durable once they are. Each record is framed as
+//
+//   [uint32 length][uint32 checksum][uint64 sequence][uint8 type][body]
+class WriteAheadLog {
+public:
+    using ReplayFunction = std::function<void(uint64_t sequence, LogRecordType type, const std::string& body)>;
+    
+    // Calls apply for every intact record in path, cuts off a torn tail left by
+    // a crash and returns the last sequence seen (0 for an empty or missing log)
+    static uint64_t Replay(const std::string& path, const ReplayFunction& apply);
+    
+    // Opens path for appending, lastSequence is the last record already in it
+    WriteAheadLog(const std::string& path, uint64_t lastSequence, std::chrono::microseconds interval);
+    ~WriteAheadLog();
+    
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+    
+    // Buffer a record, callers number records in increasing order
+    void Append(uint64_t sequence, LogRecordType type, const std::string& body);
+    
+    // Block until every record up to sequence is on disk, false when the log
+    // is closed before they got there
+    bool WaitDurable(uint64_t sequence);
+    
+    // Drop the whole log once a snapshot covers it (callers must stop appends meanwhile)
+    void Truncate();
+    
+private:
+    void FlushTask();
+    
+    std::string path;
+    int fd;
+    std::chrono::microseconds interval;
+    
+    std::mutex mutex;
+    std::condition_variable flushNeeded;
+    std::condition_variable flushed;
+    std::string pending;        // Framed records not written yet
+    uint64_t lastSequence;      // Last sequence appended
+    uint64_t durableSequence;   // Last sequence known to be on disk
+    uint64_t durableSize;       // File size up to the end of durableSequence
+    bool torn;                  // The file may hold part of a failed batch past durableSize
+    bool flushing;              // Flush thread is writing a batch outside the lock
+    bool stopping;
+    bool closed;                // Flush thread has exited
+    std::thread flushThread;
+};
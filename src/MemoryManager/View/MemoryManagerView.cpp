@@ -42,6 +42,14 @@ void MemoryManagerView::GenerateDump() const {
     
     for (const auto& block : blocks) {
         outFile << FormatMemoryBlock(block) << std::endl;
+        if (block.spilled) {
+            outFile << "Content: in the spill file" << std::endl << std::endl;
+            continue;
+        }
+        if (block.compressed) {
+            outFile << "Compressed: " << block.size << " -> " << block.compressedSize << " bytes" << std::endl << std::endl;
+            continue;
+        }
         
         // Dump block content as hex
         const char* memPtr = static_cast<const char*>(model->GetMemoryPointer()) + block.offset;
@@ -82,8 +90,9 @@ std::string MemoryManagerView::FormatMemoryBlock(const MemoryBlock& block) const
     oss << "Block ID: " << block.id << " | "
         << "Offset: " << block.offset << " | "
         << "Size: " << block.size << " bytes | "
-        << "Type: " << block.type << " | "
+        << "Type: " << model->GetTypeName(block.typeId) << " | "
         << "RefCount: " << block.refCount << " | "
-        << "Status: " << (block.isAllocated ? "Allocated" : "Free");
+        << "Status: " << (!block.isAllocated ? "Free" : block.spilled ? "Spilled" : "Allocated") << " | "
+        << "Accesses: " << block.accessCount;
     return oss.str();
 }
\ No newline at end of file
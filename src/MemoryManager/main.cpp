@@ -1,19 +1,46 @@
 #include "Controller/MemoryManagerController.h"
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <cstdlib>
+#include <vector>
+
+// Tenant names also name their dump subfolder
+static const char* TENANT_NAME_CHARS = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-";
 
 void printUsage(const char* programName) {
-    std::cout << "Usage: " << programName << " --port PORT --memsize SIZE_MB --dumpFolder FOLDER" << std::endl;
+    std::cout << "Usage: " << programName << " --port PORT --memsize SIZE_MB --dumpFolder FOLDER [--socket PATH] [--shm NAME] [--restore FILE] [--wal LOG] [--wal-interval MS] [--replicate-to ADDR] [--role ROLE] [--spill SPILL] [--compress PASSES] [--numa-node NODE] [--tenant NAME:SIZE_MB]..." << std::endl;
     std::cout << "  PORT: Port to listen on" << std::endl;
     std::cout << "  SIZE_MB: Size of memory to allocate in megabytes" << std::endl;
     std::cout << "  FOLDER: Folder to store memory dumps" << std::endl;
+    std::cout << "  PATH: Unix domain socket to listen on as well, for clients on the same host" << std::endl;
+    std::cout << "  NAME: POSIX shared memory name (e.g. /mpointers) to back the arena, local clients map it" << std::endl;
+    std::cout << "  FILE: Snapshot to start from (written by the Snapshot RPC), its arena size replaces SIZE_MB" << std::endl;
+    std::cout << "  LOG: Write-ahead log to replay on start and append every change to (disables shared-memory access)" << std::endl;
+    std::cout << "  MS: Group commit interval, the log is synced at most once per interval (default 5)" << std::endl;
+    std::cout << "  ADDR: Follower (host:port) to stream every change to asynchronously (disables shared-memory access)" << std::endl;
+    std::cout << "  ROLE: primary (default) or follower, which serves reads and applies its primary's changes until promoted" << std::endl;
+    std::cout << "  SPILL: File for the least recently used blocks once the arena is full, paged back in on access (disables shared-memory access)" << std::endl;
+    std::cout << "  PASSES: Compress blocks left idle this many collector passes, large blocks after one (0 disables, the default; disables shared-memory access)" << std::endl;
+    std::cout << "  NODE: NUMA node to keep the arena and every thread on, run one mem-mgr per node and connect clients to all" << std::endl;
+    std::cout << "  NAME:SIZE_MB: Tenant with its own arena of SIZE_MB, lock and collector, chosen by clients at connect time (repeatable)" << std::endl;
 }
 
 int main(int argc, char** argv) {
     int port = 50051;
     size_t memorySize = 100 * 1024 * 1024; // Default: 100MB
     std::string dumpFolder = "./dumps";
+    std::string socketPath;
+    std::string sharedName;
+    std::string restorePath;
+    std::string walPath;
+    int walIntervalMs = 5;
+    std::string replicaAddress;
+    bool follower = false;
+    std::string spillPath;
+    int compressIdlePasses = 0;
+    int numaNode = -1;
+    std::vector<std::pair<std::string, size_t>> tenants;
     
     // Parse command line arguments
     for (int i = 1; i < argc; i += 2) {
@@ -32,6 +59,56 @@ int main(int argc, char** argv) {
             memorySize = static_cast<size_t>(sizeMB) * 1024 * 1024;
         } else if (arg == "--dumpFolder") {
             dumpFolder = argv[i + 1];
+        } else if (arg == "--socket") {
+            socketPath = argv[i + 1];
+        } else if (arg == "--shm") {
+            sharedName = argv[i + 1];
+        } else if (arg == "--restore") {
+            restorePath = argv[i + 1];
+        } else if (arg == "--wal") {
+            walPath = argv[i + 1];
+        } else if (arg == "--wal-interval") {
+            walIntervalMs = std::atoi(argv[i + 1]);
+            if (walIntervalMs <= 0) {
+                std::cerr << "Invalid log interval: " << argv[i + 1] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--replicate-to") {
+            replicaAddress = argv[i + 1];
+        } else if (arg == "--role") {
+            std::string role = argv[i + 1];
+            if (role != "primary" && role != "follower") {
+                std::cerr << "Invalid role: " << role << std::endl;
+                return 1;
+            }
+            follower = role == "follower";
+        } else if (arg == "--spill") {
+            spillPath = argv[i + 1];
+        } else if (arg == "--compress") {
+            compressIdlePasses = std::atoi(argv[i + 1]);
+            if (compressIdlePasses < 0) {
+                std::cerr << "Invalid compression passes: " << argv[i + 1] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--numa-node") {
+            numaNode = std::atoi(argv[i + 1]);
+            if (numaNode < 0) {
+                std::cerr << "Invalid NUMA node: " << argv[i + 1] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--tenant") {
+            std::string tenant = argv[i + 1];
+            size_t colon = tenant.find(':');
+            std::string name = tenant.substr(0, colon);
+            int sizeMB = colon == std::string::npos ? 0 : std::atoi(tenant.c_str() + colon + 1);
+            bool duplicate = std::any_of(tenants.begin(), tenants.end(),
+                [&name](const std::pair<std::string, size_t>& other) { return other.first == name; });
+            if (name.empty() || name.find_first_not_of(TENANT_NAME_CHARS) != std::string::npos ||
+                sizeMB <= 0 || duplicate) {
+                std::cerr << "Invalid tenant: " << tenant << std::endl;
+                return 1;
+            }
+            tenants.emplace_back(name, static_cast<size_t>(sizeMB) * 1024 * 1024);
         } else if (arg == "--help") {
             printUsage(argv[0]);
             return 0;
@@ -46,9 +123,41 @@ int main(int argc, char** argv) {
     std::cout << "  Port: " << port << std::endl;
     std::cout << "  Memory Size: " << (memorySize / (1024 * 1024)) << "MB" << std::endl;
     std::cout << "  Dump Folder: " << dumpFolder << std::endl;
+    if (!socketPath.empty()) {
+        std::cout << "  Unix Socket: " << socketPath << std::endl;
+    }
+    if (!sharedName.empty()) {
+        std::cout << "  Shared Memory: " << sharedName << std::endl;
+    }
+    if (!restorePath.empty()) {
+        std::cout << "  Restore From: " << restorePath << std::endl;
+    }
+    if (!walPath.empty()) {
+        std::cout << "  Write-Ahead Log: " << walPath << " (sync every " << walIntervalMs << "ms)" << std::endl;
+    }
+    if (!replicaAddress.empty()) {
+        std::cout << "  Replicate To: " << replicaAddress << std::endl;
+    }
+    if (follower) {
+        std::cout << "  Role: follower (read-only until promoted)" << std::endl;
+    }
+    if (!spillPath.empty()) {
+        std::cout << "  Spill File: " << spillPath << std::endl;
+    }
+    if (compressIdlePasses > 0) {
+        std::cout << "  Compression: blocks idle for " << compressIdlePasses << " collector passes" << std::endl;
+    }
+    if (numaNode >= 0) {
+        std::cout << "  NUMA Node: " << numaNode << std::endl;
+    }
+    for (const auto& tenant : tenants) {
+        std::cout << "  Tenant: " << tenant.first << " (" << (tenant.second / (1024 * 1024)) << "MB)" << std::endl;
+    }
     
     try {
-        MemoryManagerController controller(port, memorySize, dumpFolder);
+        MemoryManagerController controller(port, memorySize, dumpFolder, socketPath, sharedName, restorePath,
+                                            walPath, walIntervalMs, replicaAddress, follower, spillPath,
+                                            compressIdlePasses, numaNode, tenants);
         controller.Start();
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
@@ -57,4 +166,3 @@ int main(int argc, char** argv) {
     
     return 0;
 }
-</antA
\ No newline at end of file
@@ -1,7 +1,14 @@
 #pragma once
 
 #include "MPointer.h"
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 template <typename T>
 class Node {
@@ -15,24 +22,116 @@ public:
 
 template <typename T>
 class LinkedList {
+    static_assert(std::is_trivially_copyable<T>::value, "LinkedList nodes are transferred as raw bytes");
+    
 public:
+    // Nodes fetched per Traverse RPC while iterating
+    static constexpr size_t PREFETCH_NODES = 64;
+    
+    // Input iterator, the server follows the next pointers and returns
+    // PREFETCH_NODES nodes per round trip
+    class const_iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+        
+        const_iterator() : list(nullptr), index(0), windowStart(0), cursor(-1) {}
+        
+        reference operator*() const {
+            if (index < windowStart || index >= windowStart + window.size()) {
+                fetchWindow();
+            }
+            return window[index - windowStart];
+        }
+        
+        pointer operator->() const { return &**this; }
+        
+        const_iterator& operator++() {
+            ++index;
+            return *this;
+        }
+        
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++index;
+            return previous;
+        }
+        
+        bool operator==(const const_iterator& other) const { return index == other.index; }
+        bool operator!=(const const_iterator& other) const { return index != other.index; }
+        
+    private:
+        friend class LinkedList<T>;
+        const_iterator(const LinkedList<T>* list, size_t index)
+            : list(list), index(index), windowStart(0), cursor(&list->head) {}
+        
+        void fetchWindow() const {
+            if (index < windowStart) {
+                // Went back before the window, start over from the head
+                windowStart = 0;
+                window.clear();
+                cursor = &list->head;
+            }
+            
+            // Continue the chain where the previous window ended
+            size_t fetched = windowStart + window.size();
+            std::vector<std::string> nodes;
+            int64_t nextId = -1;
+            if (!GRPCClient::getInstance().Traverse(cursor, offsetof(Node<T>, next), static_cast<int>(index - fetched),
+                                                    PREFETCH_NODES, nodes, nextId) || nodes.empty()) {
+                throw std::runtime_error("Failed to get list nodes from memory");
+            }
+            
+            window.resize(nodes.size());
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                int64_t followingId;
+                decodeNode(nodes[i], window[i], followingId);
+            }
+            windowStart = index;
+            cursor = nextId;
+        }
+        
+        const LinkedList<T>* list;
+        size_t index;
+        mutable size_t windowStart;
+        mutable int64_t cursor; // Id of the first node after the window
+        mutable std::vector<T> window;
+    };
+    
     LinkedList() : size(0) {}
     
+    // A copy would share the nodes and release their links twice
+    LinkedList(const LinkedList&) = delete;
+    LinkedList& operator=(const LinkedList&) = delete;
+    
+    // head and tail release themselves, the links between nodes are released here
+    ~LinkedList() {
+        try {
+            releaseLinks();
+        } catch (const std::exception&) {
+            // Server unreachable, there is nothing left to release the links on
+        }
+    }
+    
     // Add element to the end of the list
     void add(const T& data) {
         MPointer<Node<T>> newNode = MPointer<Node<T>>::New();
-        *newNode = Node<T>(data);
+        newNode = Node<T>(data);
+        int64_t newId = &newNode;
         
         if (!head.isValid()) {
             head = newNode;
         } else {
-            MPointer<Node<T>> current = head;
-            while ((*current).next.isValid()) {
-                current = (*current).next;
-            }
-            (*current).next = newNode;
+            // The last node's next field takes its own reference to the new node
+            linkNext(&tail, newId);
+            GRPCClient::getInstance().IncreaseRefCount(newId);
         }
         
+        // Appending never walks the list: a constant number of RPCs per add
+        tail = std::move(newNode);
         size++;
     }
     
@@ -42,56 +141,60 @@ public:
             return false;
         }
         
-        if (index == 0) {
-            // Remove first element
-            if (head.isValid()) {
-                MPointer<Node<T>> temp = head;
-                head = (*temp).next;
-                size--;
-                return true;
+        // One traversal returns the predecessor's predecessor, the predecessor and
+        // the removed node, whose next fields hold the three ids we need
+        int first = std::max(0, index - 2);
+        std::vector<std::pair<T, int64_t>> nodes = readNodes(first, index - first + 1);
+        int position = index - first;
+        int64_t removedId = position >= 1 ? nodes[position - 1].second : &head;
+        int64_t predecessorId = index >= 2 ? nodes[0].second : &head;
+        int64_t nextId = nodes[position].second;
+        
+        // Removing the last node moves the tail back to its predecessor
+        if (index == size - 1) {
+            if (index == 0) {
+                tail = MPointer<Node<T>>();
+            } else {
+                GRPCClient::getInstance().IncreaseRefCount(predecessorId);
+                tail = MPointer<Node<T>>::Adopt(predecessorId);
             }
-            return false;
         }
         
-        // Find the node before the one to remove
-        MPointer<Node<T>> current = head;
-        for (int i = 0; i < index - 1; i++) {
-            current = (*current).next;
+        // The successor's reference moves from the removed node to its predecessor
+        if (index == 0) {
+            head = MPointer<Node<T>>::Adopt(nextId);
+        } else {
+            linkNext(predecessorId, nextId);
+            GRPCClient::getInstance().DecreaseRefCount(removedId);
         }
         
-        // Remove the node
-        MPointer<Node<T>> toRemove = (*current).next;
-        (*current).next = (*toRemove).next;
         size--;
         
         return true;
     }
     
-    // Get element at specified index
+    // Get element at specified index (one Traverse RPC)
     T get(int index) const {
         if (index < 0 || index >= size) {
             throw std::out_of_range("Index out of range");
         }
         
-        MPointer<Node<T>> current = head;
-        for (int i = 0; i < index; i++) {
-            current = (*current).next;
-        }
-        
-        return (*current).data;
+        return readNodes(index, 1).front().first;
     }
     
     // Display all elements in the list
     void display() const {
-        MPointer<Node<T>> current = head;
         std::cout << "List: ";
-        while (current.isValid()) {
-            std::cout << (*current).data << " ";
-            current = (*current).next;
+        for (const T& value : *this) {
+            std::cout << value << " ";
         }
         std::cout << std::endl;
     }
     
+    // Iteration in list order
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size); }
+    
     // Get the size of the list
     int getSize() const {
         return size;
@@ -103,6 +206,68 @@ public:
     }
     
 private:
+    // Nodes are read as raw bytes, decoding them through MPointer<Node<T>>::operator*
+    // would build temporaries that send refcount RPCs for the embedded next pointer
+    static void decodeNode(const std::string& bytes, T& data, int64_t& nextId) {
+        if (bytes.size() < sizeof(Node<T>)) {
+            throw std::runtime_error("Malformed list node");
+        }
+        memcpy(&data, bytes.data() + offsetof(Node<T>, data), sizeof(T));
+        memcpy(&nextId, bytes.data() + offsetof(Node<T>, next), sizeof(nextId));
+    }
+    
+    // Data and next id of count nodes starting at position first, in one RPC
+    std::vector<std::pair<T, int64_t>> readNodes(int first, int count) const {
+        std::vector<std::string> bytes;
+        int64_t nextId = -1;
+        if (!GRPCClient::getInstance().Traverse(&head, offsetof(Node<T>, next), first, count, bytes, nextId) ||
+            static_cast<int>(bytes.size()) != count) {
+            throw std::runtime_error("Failed to get list nodes from memory");
+        }
+        
+        std::vector<std::pair<T, int64_t>> nodes(bytes.size());
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            decodeNode(bytes[i], nodes[i].first, nodes[i].second);
+        }
+        return nodes;
+    }
+    
+    // Drop the reference each next field holds to the node after it
+    void releaseLinks() {
+        // Collect every link first, releasing one can free the nodes behind it
+        std::vector<int64_t> links;
+        int64_t cursor = &head;
+        while (cursor != -1 && static_cast<int>(links.size()) < size - 1) {
+            std::vector<std::string> nodes;
+            int64_t nextId = -1;
+            if (!GRPCClient::getInstance().Traverse(cursor, offsetof(Node<T>, next), 0, PREFETCH_NODES, nodes, nextId) ||
+                nodes.empty()) {
+                throw std::runtime_error("Failed to get list nodes from memory");
+            }
+            for (const std::string& bytes : nodes) {
+                T data;
+                int64_t followingId;
+                decodeNode(bytes, data, followingId);
+                if (followingId != -1) {
+                    links.push_back(followingId);
+                }
+            }
+            cursor = nextId;
+        }
+        
+        for (int64_t id : links) {
+            GRPCClient::getInstance().DecreaseRefCount(id);
+        }
+    }
+    
+    // Overwrite only the next field of a stored node
+    static void linkNext(int64_t id, int64_t nextId) {
+        if (!GRPCClient::getInstance().SetRange(id, offsetof(Node<T>, next), &nextId, sizeof(nextId))) {
+            throw std::runtime_error("Failed to link list node");
+        }
+    }
+    
     MPointer<Node<T>> head;
+    MPointer<Node<T>> tail; // Last node, so add can link behind it directly
     int size;
 };
\ No newline at end of file
@@ -1,9 +1,17 @@
 #include "MPointer.h"
 #include "LinkedList.h"
+#include "MArray.h"
+#include "MVector.h"
+#include "MHashMap.h"
+#include "MScope.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <thread>
 #include <chrono>
+#include <vector>
+#include <utility>
 
 // Función para probar operaciones básicas de MPointers
 void testBasicOperations() {
@@ -17,8 +25,8 @@ void testBasicOperations() {
     
     // Asignar valores
     std::cout << "Asignando valores..." << std::endl;
-    *intPtr = 42;
-    *doublePtr = 3.14159;
+    intPtr = 42;
+    doublePtr = 3.14159;
     
     char testString[64] = "Hola, mundo!";
     bool setResult = GRPCClient::getInstance().Set(&stringPtr, testString, strlen(testString) + 1);
@@ -47,6 +55,273 @@ void testBasicOperations() {
     // Los destructores se llamarán automáticamente al salir de esta función
 }
 
+// Función para verificar que mover MPointers no genera RPCs de refCount
+void testMoveSemantics() {
+    std::cout << "\n===== PRUEBA DE SEMÁNTICA DE MOVIMIENTO =====\n" << std::endl;
+    
+    GRPCClient& client = GRPCClient::getInstance();
+    
+    // Con varios servidores, este hilo crea todo en el mismo y ya tiene int registrado
+    client.SetShardSelection(ShardSelection::ConsistentHash);
+    MPointer<int> warmup = MPointer<int>::New();
+    
+    // New() solo debe costar el Create, el retorno se mueve
+    client.ResetRpcCount();
+    MPointer<int> source = MPointer<int>::New();
+    uint64_t createRpcs = client.GetRpcCount();
+    std::cout << "RPCs de New(): " << createRpcs << " (esperado: 1)" << std::endl;
+    
+    // El descriptor de un tipo nuevo se registra una sola vez por conexión
+    struct Punto { int x; int y; };
+    client.ResetRpcCount();
+    MPointer<Punto> firstPoint = MPointer<Punto>::New();
+    MPointer<Punto> secondPoint = MPointer<Punto>::New();
+    uint64_t typeRpcs = client.GetRpcCount();
+    std::cout << "RPCs de dos New() de un tipo nuevo: " << typeRpcs << " (esperado: 3)" << std::endl;
+    
+    // Construcción y asignación por movimiento
+    client.ResetRpcCount();
+    MPointer<int> moved = std::move(source);
+    MPointer<int> target;
+    target = std::move(moved);
+    uint64_t moveRpcs = client.GetRpcCount();
+    std::cout << "RPCs al mover: " << moveRpcs << " (esperado: 0)" << std::endl;
+    std::cout << "Origen válido tras mover: " << (source.isValid() ? "Sí" : "No") << std::endl;
+    
+    // Crecimiento de un vector: los elementos se reubican por movimiento
+    std::vector<MPointer<int>> pointers;
+    for (int i = 0; i < 8; ++i) {
+        pointers.push_back(MPointer<int>::New());
+    }
+    client.ResetRpcCount();
+    pointers.reserve(pointers.capacity() * 4);
+    pointers.push_back(std::move(target));
+    uint64_t growthRpcs = client.GetRpcCount();
+    std::cout << "RPCs al crecer el vector: " << growthRpcs << " (esperado: 0)" << std::endl;
+    
+    client.SetShardSelection(ShardSelection::LeastLoaded);
+    
+    bool passed = createRpcs == 1 && typeRpcs == 3 && moveRpcs == 0 && growthRpcs == 0 && !source.isValid();
+    std::cout << "Resultado: " << (passed ? "Éxito" : "Fallido") << std::endl;
+}
+
+// Función para probar el reparto de bloques entre varios Memory Managers
+void testSharding() {
+    std::cout << "\n===== PRUEBA DE VARIOS SERVIDORES =====\n" << std::endl;
+    
+    GRPCClient& client = GRPCClient::getInstance();
+    size_t shardCount = client.GetShardCount();
+    
+    // Cada Create va al servidor con más memoria libre, el id lleva el servidor
+    std::vector<MPointer<int>> pointers;
+    std::vector<int64_t> ids;
+    std::vector<bool> usedShards(shardCount, false);
+    for (int i = 0; i < 16; ++i) {
+        pointers.push_back(MPointer<int>::New());
+        pointers.back() = i * 11;
+        ids.push_back(&pointers.back());
+        usedShards[shardCount == 1 ? 0 : ShardOfId(ids.back())] = true;
+    }
+    size_t shardsUsed = std::count(usedShards.begin(), usedShards.end(), true);
+    std::cout << "Servidores: " << shardCount << ", con bloques: " << shardsUsed << std::endl;
+    
+    // Una lectura por lotes se reparte entre los servidores dueños
+    std::vector<std::string> values;
+    bool batchOk = client.GetBatch(ids, values) && values.size() == ids.size();
+    for (size_t i = 0; batchOk && i < values.size(); ++i) {
+        int value;
+        memcpy(&value, values[i].data(), sizeof(int));
+        batchOk = value == static_cast<int>(i) * 11;
+    }
+    std::cout << "Lectura por lotes correcta: " << (batchOk ? "Sí" : "No") << std::endl;
+    
+    bool passed = shardsUsed == shardCount && batchOk;
+    std::cout << "Resultado: " << (passed ? "Éxito" : "Fallido") << std::endl;
+}
+
+// Función para probar MArray con transferencias por rangos
+void testMArray() {
+    std::cout << "\n===== PRUEBA DE MARRAY =====\n" << std::endl;
+    
+    GRPCClient& client = GRPCClient::getInstance();
+    const size_t count = 50000;
+    
+    MArray<int> array = MArray<int>::New(count);
+    std::vector<int> values(count);
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = static_cast<int>(i * 3);
+    }
+    
+    // Escritura completa: 200KB caben en un solo RPC
+    client.ResetRpcCount();
+    array.write(0, values);
+    uint64_t writeRpcs = client.GetRpcCount();
+    std::cout << "RPCs para escribir " << count << " elementos: " << writeRpcs << std::endl;
+    
+    // Lectura de un rango y acceso por índice
+    std::vector<int> slice = array.read(1000, 10);
+    array[5] = -5;
+    int fifth = array[5];
+    std::cout << "array[1000..1009]: ";
+    for (int value : slice) {
+        std::cout << value << " ";
+    }
+    std::cout << std::endl << "array[5] = " << fifth << std::endl;
+    
+    // Iteración por bloques
+    client.ResetRpcCount();
+    long long sum = 0;
+    for (int value : array) {
+        sum += value;
+    }
+    uint64_t iterateRpcs = client.GetRpcCount();
+    std::cout << "Suma: " << sum << ", RPCs al iterar: " << iterateRpcs << std::endl;
+    
+    long long expected = 0;
+    for (size_t i = 0; i < count; ++i) {
+        expected += (i == 5) ? -5 : values[i];
+    }
+    // Con la arena compartida mapeada los accesos no generan RPCs
+    size_t chunks = (count + MArray<int>::CHUNK_ELEMENTS - 1) / MArray<int>::CHUNK_ELEMENTS;
+    
+    // Redimensionar conserva el id y el contenido
+    int64_t idBefore = &array;
+    array.resize(count * 2);
+    int kept = array[count - 1];
+    int added = array[count * 2 - 1];
+    std::cout << "Tras resize: tamaño " << array.size() << ", id " << idBefore << " -> " << &array
+              << ", array[" << count - 1 << "] = " << kept << ", array[" << count * 2 - 1 << "] = " << added << std::endl;
+    
+    bool passed = writeRpcs <= 1 && slice[0] == 3000 && fifth == -5 && sum == expected && iterateRpcs <= chunks &&
+                  &array == idBefore && kept == values[count - 1] && added == 0;
+    std::cout << "Resultado: " << (passed ? "Éxito" : "Fallido") << std::endl;
+}
+
+// Función para probar MVector (un solo bloque que crece en el servidor)
+void testMVector() {
+    std::cout << "\n===== PRUEBA DE MVECTOR =====\n" << std::endl;
+    
+    GRPCClient& client = GRPCClient::getInstance();
+    const size_t count = 1000;
+    
+    // push_back: el bloque se redimensiona pocas veces y conserva su id
+    MVector<int> vec;
+    client.ResetRpcCount();
+    vec.push_back(0);
+    int64_t id = &vec;
+    for (size_t i = 1; i < count; ++i) {
+        vec.push_back(static_cast<int>(i));
+    }
+    uint64_t pushRpcs = client.GetRpcCount();
+    std::cout << "RPCs para " << count << " push_back: " << pushRpcs << ", capacidad: " << vec.capacity() << std::endl;
+    
+    // append en bloque y acceso por índice
+    std::vector<int> tail(count, 7);
+    client.ResetRpcCount();
+    vec.append(tail);
+    uint64_t appendRpcs = client.GetRpcCount();
+    vec[10] = -10;
+    std::cout << "RPCs para append de " << count << " elementos: " << appendRpcs << std::endl;
+    std::cout << "vec[10] = " << vec[10] << ", vec[" << count - 1 << "] = " << vec[count - 1]
+              << ", vec[" << count << "] = " << vec[count] << ", tamaño: " << vec.size() << std::endl;
+    
+    long long sum = 0;
+    for (int value : vec) {
+        sum += value;
+    }
+    long long expected = static_cast<long long>(count) * (count - 1) / 2 - 10 - 10 + 7LL * count;
+    
+    bool passed = vec.size() == 2 * count && &vec == id && pushRpcs <= count + 10 && appendRpcs <= 2 &&
+                  vec[10] == -10 && sum == expected;
+    std::cout << "Resultado: " << (passed ? "Éxito" : "Fallido") << std::endl;
+}
+
+// Función para probar MHashMap (tabla con direccionamiento abierto en el servidor)
+void testMHashMap() {
+    std::cout << "\n===== PRUEBA DE MHASHMAP =====\n" << std::endl;
+    
+    GRPCClient& client = GRPCClient::getInstance();
+    const int count = 2000;
+    
+    // Las inserciones hacen crecer la tabla varias veces de forma incremental
+    MHashMap<int, long long> map;
+    client.ResetRpcCount();
+    for (int i = 0; i < count; ++i) {
+        map.insert(i, static_cast<long long>(i) * i);
+    }
+    uint64_t insertRpcs = client.GetRpcCount();
+    std::cout << "Insertadas " << map.size() << " claves, capacidad " << map.capacity()
+              << ", RPCs por inserción: " << static_cast<double>(insertRpcs) / count << std::endl;
+    
+    // Sobrescribir y borrar
+    map.insert(10, -1);
+    for (int i = 0; i < count; i += 2) {
+        map.erase(i + 1);
+    }
+    
+    // Cada búsqueda es una lectura de rango
+    client.ResetRpcCount();
+    bool valuesOk = true;
+    for (int i = 0; i < count; ++i) {
+        long long value = 0;
+        bool found = map.get(i, value);
+        bool expectedFound = i % 2 == 0;
+        long long expected = i == 10 ? -1 : static_cast<long long>(i) * i;
+        if (found != expectedFound || (found && value != expected)) {
+            valuesOk = false;
+        }
+    }
+    uint64_t lookupRpcs = client.GetRpcCount();
+    std::cout << "RPCs por búsqueda: " << static_cast<double>(lookupRpcs) / count
+              << ", map[10] = " << map.at(10) << ", contiene 11: " << (map.contains(11) ? "sí" : "no") << std::endl;
+    
+    bool passed = valuesOk && map.size() == count / 2 && lookupRpcs <= 2 * count;
+    std::cout << "Resultado: " << (passed ? "Éxito" : "Fallido") << std::endl;
+}
+
+// Función para probar las operaciones atómicas en el servidor
+void testAtomics() {
+    std::cout << "\n===== PRUEBA DE OPERACIONES ATÓMICAS =====\n" << std::endl;
+    
+    MPointer<int> counter = MPointer<int>::New();
+    counter = 0;
+    
+    // Varios hilos incrementan el mismo contador sin perder actualizaciones
+    const int threads = 4;
+    const int increments = 250;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&counter]() {
+            for (int i = 0; i < increments; ++i) {
+                counter.fetchAdd(1);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    int total = *counter;
+    std::cout << "Contador tras " << threads * increments << " incrementos: " << total << std::endl;
+    
+    // Compare-and-swap: el primero acierta, el segundo recibe el valor actual
+    int expected = total;
+    bool firstSwap = counter.compareExchange(expected, -1);
+    expected = total;
+    bool secondSwap = counter.compareExchange(expected, 5);
+    std::cout << "CAS esperado " << total << ": " << (firstSwap ? "Éxito" : "Fallido")
+              << ", segundo CAS: " << (secondSwap ? "Éxito" : "Fallido") << " (valor actual " << expected << ")" << std::endl;
+    
+    // Exchange sobre un entero de 8 bytes
+    MPointer<long long> flag = MPointer<long long>::New();
+    flag = 1LL << 40;
+    long long old = flag.exchange(7);
+    std::cout << "Exchange devolvió " << old << ", nuevo valor " << *flag << std::endl;
+    
+    bool passed = total == threads * increments && firstSwap && !secondSwap && expected == -1 &&
+                  old == (1LL << 40) && *flag == 7;
+    std::cout << "Resultado: " << (passed ? "Éxito" : "Fallido") << std::endl;
+}
+
 // Función para probar LinkedList usando MPointers
 void testLinkedList() {
     std::cout << "\n===== PRUEBA DE LINKED LIST =====\n" << std::endl;
@@ -61,9 +336,12 @@ void testLinkedList() {
         std::cout << "Agregado: " << (i * 10) << ", Tamaño de la lista: " << list.getSize() << std::endl;
     }
     
-    // Mostrar elementos
+    // Mostrar elementos (el iterador trae los nodos por lotes)
     std::cout << "\nMostrando la lista:" << std::endl;
+    GRPCClient::getInstance().ResetRpcCount();
     list.display();
+    std::cout << "RPCs para recorrer " << list.getSize() << " nodos: "
+              << GRPCClient::getInstance().GetRpcCount() << std::endl;
     
     // Obtener elementos por índice
     std::cout << "\nAcceso a elementos por índice:" << std::endl;
@@ -81,10 +359,47 @@ void testLinkedList() {
     std::cout << "Después de eliminar el primer elemento:" << std::endl;
     list.display();
     
+    list.remove(list.getSize() - 1); // Eliminar el último elemento (mueve la cola)
+    list.add(99);
+    std::cout << "Después de eliminar el último y agregar 99:" << std::endl;
+    list.display();
+    
     // La lista se destruirá automáticamente al salir de esta función
     // Esto debería decrementar los refCounts de todos los MPointers
 }
 
+// Función para probar MScope: los bloques de una región se liberan con un solo RPC
+void testMScope() {
+    std::cout << "\n===== PRUEBA DE MSCOPE =====\n" << std::endl;
+    
+    GRPCClient& client = GRPCClient::getInstance();
+    const int count = 50;
+    uint64_t copyRpcs = 0;
+    
+    client.ResetRpcCount();
+    {
+        MScope scope;
+        std::vector<MPointer<int>> temps;
+        for (int i = 0; i < count; ++i) {
+            temps.push_back(MPointer<int>::New());
+        }
+        
+        // Copiar punteros de la región no genera RPCs de refCount
+        uint64_t before = client.GetRpcCount();
+        std::vector<MPointer<int>> copies(temps.begin(), temps.end());
+        copyRpcs = client.GetRpcCount() - before;
+        client.ResetRpcCount();
+        
+        std::cout << "Creados " << count << " punteros en la región " << scope.id()
+                  << ", RPCs al copiarlos: " << copyRpcs << std::endl;
+    }
+    uint64_t releaseRpcs = client.GetRpcCount();
+    std::cout << "RPCs al salir del ámbito: " << releaseRpcs << " (esperado: 1)" << std::endl;
+    
+    bool passed = copyRpcs == 0 && releaseRpcs == 1;
+    std::cout << "Resultado: " << (passed ? "Éxito" : "Fallido") << std::endl;
+}
+
 // Función para probar el recolector de basura
 void testGarbageCollection() {
     std::cout << "\n===== PRUEBA DEL RECOLECTOR DE BASURA =====\n" << std::endl;
@@ -96,8 +411,8 @@ void testGarbageCollection() {
         MPointer<int> tempPtr1 = MPointer<int>::New();
         MPointer<int> tempPtr2 = MPointer<int>::New();
         
-        *tempPtr1 = 100;
-        *tempPtr2 = 200;
+        tempPtr1 = 100;
+        tempPtr2 = 200;
         
         std::cout << "tempPtr1 = " << *tempPtr1 << ", tempPtr2 = " << *tempPtr2 << std::endl;
         std::cout << "Saliendo del ámbito, los punteros serán liberados..." << std::endl;
@@ -114,21 +429,32 @@ void testGarbageCollection() {
 
 int main(int argc, char** argv) {
     if (argc < 2) {
-        std::cerr << "Uso: " << argv[0] << " <puerto>" << std::endl;
+        std::cerr << "Uso: " << argv[0] << " <puerto> [<puerto>...]" << std::endl;
         return 1;
     }
     
-    int port = std::atoi(argv[1]);
-    std::cout << "Conectando al Memory Manager en el puerto " << port << "..." << std::endl;
+    // Con varios puertos los bloques se reparten entre varios Memory Managers
+    std::string addresses;
+    for (int i = 1; i < argc; ++i) {
+        addresses += (i > 1 ? "," : "") + std::string("localhost:") + argv[i];
+    }
+    std::cout << "Conectando al Memory Manager en " << addresses << "..." << std::endl;
     
     try {
         // Inicializar conexión al Memory Manager
-        MPointer<int>::Init(port);
+        MPointer<int>::Init(addresses);
         std::cout << "Conexión establecida." << std::endl;
         
         // Ejecutar pruebas
         testBasicOperations();
+        testMoveSemantics();
+        testSharding();
+        testMArray();
+        testMVector();
+        testMHashMap();
+        testAtomics();
         testLinkedList();
+        testMScope();
         testGarbageCollection();
         
         std::cout << "\nTodas las pruebas completadas." << std::endl;
@@ -0,0 +1,303 @@
+#include "MemoryManagerModel.h"
+#include "WriteAheadLog.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Pruebas del modelo y su write-ahead log sin servidor: corren en este
+// proceso sobre archivos de un directorio temporal.
+//
+//   mem-mgr-wal-test
+
+namespace {
+
+constexpr size_t ARENA_SIZE = 1024 * 1024;
+constexpr int SYNC_INTERVAL_MS = 1;
+
+std::string testFolder;
+
+// Imprime la comprobación que falla y devuelve su resultado
+bool check(bool condition, const std::string& description) {
+    if (!condition) {
+        std::cout << "  Falla: " << description << std::endl;
+    }
+    return condition;
+}
+
+std::string pathFor(const std::string& name) {
+    return testFolder + "/" + name;
+}
+
+long long fileSize(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? static_cast<long long>(info.st_size) : -1;
+}
+
+// Tamaño en disco de un registro: longitud, checksum, secuencia, tipo y cuerpo
+size_t frameSize(const std::string& body) {
+    return 2 * sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint8_t) + body.size();
+}
+
+std::string bodyFor(uint64_t sequence) {
+    return "registro " + std::to_string(sequence);
+}
+
+// Escribe los registros 1..count con WriteAheadLog y espera a que estén en disco
+void writeRecords(const std::string& path, uint64_t count) {
+    WriteAheadLog wal(path, 0, std::chrono::milliseconds(SYNC_INTERVAL_MS));
+    for (uint64_t sequence = 1; sequence <= count; ++sequence) {
+        wal.Append(sequence, LogRecordType::Write, bodyFor(sequence));
+    }
+    wal.WaitDurable(count);
+}
+
+// Reproduce el log y comprueba que trae exactamente los registros 1..expected en orden
+bool replayMatches(const std::string& path, uint64_t expected) {
+    uint64_t next = 1;
+    bool inOrder = true;
+    uint64_t last = WriteAheadLog::Replay(path, [&](uint64_t sequence, LogRecordType type, const std::string& body) {
+        inOrder = inOrder && sequence == next && type == LogRecordType::Write && body == bodyFor(sequence);
+        next++;
+    });
+    bool passed = check(last == expected, "último registro " + std::to_string(last) + ", se esperaba " +
+                        std::to_string(expected));
+    passed = check(inOrder && next == expected + 1, "los registros no llegan completos y en orden") && passed;
+    
+    size_t intactSize = 0;
+    for (uint64_t sequence = 1; sequence <= expected; ++sequence) {
+        intactSize += frameSize(bodyFor(sequence));
+    }
+    return check(fileSize(path) == static_cast<long long>(intactSize),
+                 "el log no se recortó tras el último registro íntegro") && passed;
+}
+
+bool getInt(MemoryManagerModel& model, int64_t id, int& value) {
+    size_t actualSize = 0;
+    return model.Get(id, &value, sizeof(value), actualSize) && actualSize == sizeof(value);
+}
+
+// El estado se reconstruye desde el log al reiniciar
+void testReplayAfterRestart() {
+    std::cout << "\n===== PRUEBA DE REPRODUCCIÓN TRAS REINICIO =====\n" << std::endl;
+    std::string log = pathFor("restart.wal");
+    
+    int64_t kept;
+    int64_t shared;
+    int64_t freed;
+    uint64_t sequence;
+    {
+        MemoryManagerModel model(ARENA_SIZE);
+        model.OpenLog(log, SYNC_INTERVAL_MS);
+        
+        int value = 1234;
+        kept = model.Create(sizeof(int), "int");
+        model.Set(kept, &value, sizeof(value));
+        
+        value = 99;
+        shared = model.Create(sizeof(int), "int");
+        model.Set(shared, &value, sizeof(value));
+        model.IncreaseRefCount(shared);
+        
+        freed = model.Create(sizeof(int), "int");
+        model.DecreaseRefCount(freed);
+        model.CollectGarbage();
+        
+        model.SyncLog();
+        sequence = model.GetLogSequence();
+    }
+    
+    // Nada de la primera instancia sobrevive salvo el log
+    MemoryManagerModel restarted(ARENA_SIZE);
+    restarted.OpenLog(log, SYNC_INTERVAL_MS);
+    
+    int value = 0;
+    bool passed = check(restarted.GetLogSequence() == sequence, "la secuencia no continúa donde quedó");
+    passed = check(getInt(restarted, kept, value) && value == 1234, "el primer bloque perdió su valor") && passed;
+    passed = check(getInt(restarted, shared, value) && value == 99, "el segundo bloque perdió su valor") && passed;
+    passed = check(!getInt(restarted, freed, value), "el bloque liberado volvió a existir") && passed;
+    
+    // El segundo bloque tenía dos referencias, sigue vivo tras soltar una
+    restarted.DecreaseRefCount(shared);
+    restarted.CollectGarbage();
+    passed = check(getInt(restarted, shared, value), "el contador de referencias no se reprodujo") && passed;
+    
+    int64_t next = restarted.Create(sizeof(int), "int");
+    passed = check(next != kept && next != shared && next != freed, "un bloque nuevo reutilizó un id del log") && passed;
+    
+    std::cout << "Resultado: " << (passed ? "Éxito" : "Fallido") << std::endl;
+    if (!passed) {
+        std::exit(1);
+    }
+}
+
+// Un registro cortado o corrupto al final se descarta y el log sigue desde el anterior
+void testTornTail() {
+    std::cout << "\n===== PRUEBA DE COLA CORTADA DEL LOG =====\n" << std::endl;
+    std::string log = pathFor("torn.wal");
+    
+    // Escritura a medias del último registro
+    writeRecords(log, 10);
+    bool passed = check(truncate(log.c_str(), fileSize(log) - 5) == 0, "no se pudo cortar el log");
+    passed = replayMatches(log, 9) && passed;
+    
+    // Lo que se escribe después queda detrás del último registro íntegro
+    {
+        WriteAheadLog wal(log, 9, std::chrono::milliseconds(SYNC_INTERVAL_MS));
+        wal.Append(10, LogRecordType::Write, bodyFor(10));
+        passed = check(wal.WaitDurable(10), "el registro nuevo no llegó a disco") && passed;
+    }
+    passed = replayMatches(log, 10) && passed;
+    
+    // Un byte cambiado en el cuerpo del quinto registro invalida su checksum
+    size_t offset = 0;
+    for (uint64_t sequence = 1; sequence < 5; ++sequence) {
+        offset += frameSize(bodyFor(sequence));
+    }
+    offset += frameSize(bodyFor(5)) - 1;
+    {
+        std::fstream file(log, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(offset);
+        file.put('#');
+    }
+    passed = replayMatches(log, 4) && passed;
+    
+    std::cout << "Resultado: " << (passed ? "Éxito" : "Fallido") << std::endl;
+    if (!passed) {
+        std::exit(1);
+    }
+}
+
+// Un log solo se acepta sobre el snapshot al que continúa
+void testLogMustContinueSnapshot() {
+    std::cout << "\n===== PRUEBA DE LOG Y SNAPSHOT =====\n" << std::endl;
+    std::string log = pathFor("snapshot.wal");
+    std::string staleLog = pathFor("stale.wal");
+    std::string snapshot = pathFor("state.snap");
+    
+    int64_t before;
+    int64_t after;
+    uint64_t sequence;
+    bool passed = true;
+    {
+        MemoryManagerModel model(ARENA_SIZE);
+        model.OpenLog(log, SYNC_INTERVAL_MS);
+        
+        int value = 1;
+        before = model.Create(sizeof(int), "int");
+        model.Set(before, &value, sizeof(value));
+        model.SyncLog();
+        
+        // Copia del log como quedaría si el proceso muere entre el snapshot y el recorte
+        {
+            std::ifstream source(log, std::ios::binary);
+            std::ofstream copy(staleLog, std::ios::binary);
+            copy << source.rdbuf();
+        }
+        passed = check(model.SaveSnapshot(snapshot) > 0, "no se pudo escribir el snapshot") && passed;
+        passed = check(fileSize(log) == 0, "el snapshot no vació el log") && passed;
+        
+        value = 2;
+        after = model.Create(sizeof(int), "int");
+        model.Set(after, &value, sizeof(value));
+        model.SyncLog();
+        sequence = model.GetLogSequence();
+    }
+    
+    // Sin el snapshot el log empieza a mitad de la historia
+    bool refused = false;
+    try {
+        MemoryManagerModel empty(ARENA_SIZE);
+        empty.OpenLog(log, SYNC_INTERVAL_MS);
+    } catch (const std::runtime_error&) {
+        refused = true;
+    }
+    passed = check(refused, "se aceptó un log que no continúa el estado") && passed;
+    
+    int value = 0;
+    {
+        MemoryManagerModel restored(ARENA_SIZE, "", snapshot);
+        restored.OpenLog(log, SYNC_INTERVAL_MS);
+        passed = check(restored.GetLogSequence() == sequence, "la secuencia no continúa tras el snapshot") && passed;
+        passed = check(getInt(restored, before, value) && value == 1, "se perdió el bloque del snapshot") && passed;
+        passed = check(getInt(restored, after, value) && value == 2, "se perdió el bloque del log") && passed;
+    }
+    
+    // Los registros que el snapshot ya contiene se saltan
+    {
+        MemoryManagerModel restored(ARENA_SIZE, "", snapshot);
+        uint64_t snapshotSequence = restored.GetLogSequence();
+        restored.OpenLog(staleLog, SYNC_INTERVAL_MS);
+        passed = check(restored.GetLogSequence() == snapshotSequence, "se reaplicaron registros del snapshot") && passed;
+        passed = check(getInt(restored, before, value) && value == 1, "se perdió el bloque del snapshot") && passed;
+        passed = check(!getInt(restored, after, value), "apareció un bloque posterior al snapshot") && passed;
+    }
+    
+    std::cout << "Resultado: " << (passed ? "Éxito" : "Fallido") << std::endl;
+    if (!passed) {
+        std::exit(1);
+    }
+}
+
+// Un tamaño mayor que la arena (o uno negativo convertido a size_t) no
+// debe encontrar hueco entre los bloques ni pisarlos
+void testOversizedCreate() {
+    std::cout << "\n===== PRUEBA DE CREATE DEMASIADO GRANDE =====\n" << std::endl;
+    std::string log = pathFor("oversized.wal");
+    
+    MemoryManagerModel model(1024);
+    model.OpenLog(log, SYNC_INTERVAL_MS);
+    std::vector<int64_t> ids;
+    for (int i = 0; i < 3; ++i) {
+        int value = 100 + i;
+        ids.push_back(model.Create(16, "int"));
+        model.Set(ids.back(), &value, sizeof(value));
+    }
+    uint64_t sequence = model.GetLogSequence();
+    
+    bool passed = true;
+    for (size_t size : {static_cast<size_t>(static_cast<int64_t>(-8)), static_cast<size_t>(-1), size_t(2048)}) {
+        passed = check(model.Create(size, "int") == -1, "se creó un bloque de " + std::to_string(size) + " bytes") &&
+                 passed;
+    }
+    passed = check(model.GetLogSequence() == sequence, "un Create fallido quedó en el log") && passed;
+    
+    int value = 0;
+    for (int i = 0; i < 3; ++i) {
+        passed = check(getInt(model, ids[i], value) && value == 100 + i, "un bloque existente cambió") && passed;
+    }
+    passed = check(model.Create(16, "int") != -1, "la arena dejó de aceptar bloques") && passed;
+    
+    std::cout << "Resultado: " << (passed ? "Éxito" : "Fallido") << std::endl;
+    if (!passed) {
+        std::exit(1);
+    }
+}
+
+} // namespace
+
+int main() {
+    char folder[] = "/tmp/mem-mgr-wal-test-XXXXXX";
+    if (!mkdtemp(folder)) {
+        std::cerr << "Failed to create a temporary folder" << std::endl;
+        return 1;
+    }
+    testFolder = folder;
+    
+    testReplayAfterRestart();
+    testTornTail();
+    testLogMustContinueSnapshot();
+    testOversizedCreate();
+    
+    for (const char* name : {"restart.wal", "torn.wal", "snapshot.wal", "stale.wal", "state.snap", "oversized.wal"}) {
+        unlink(pathFor(name).c_str());
+    }
+    rmdir(folder);
+    
+    std::cout << "\nTodas las pruebas pasaron" << std::endl;
+    return 0;
+}
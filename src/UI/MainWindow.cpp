@@ -2,6 +2,7 @@
 #include <QMessageBox>
 #include <iostream>
 #include <string>
+#include <utility>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -155,7 +156,7 @@ void MainWindow::onConnectClicked() {
 void MainWindow::onCreateIntPointerClicked() {
     try {
         MPointer<int> ptr = MPointer<int>::New();
-        intPointers.push_back(ptr);
+        intPointers.push_back(std::move(ptr));
         updatePointerSelector();
         QMessageBox::information(this, "Success", "Created new int pointer");
     } catch (const std::exception& e) {
@@ -167,7 +168,7 @@ void MainWindow::onCreateIntPointerClicked() {
 void MainWindow::onCreateDoublePointerClicked() {
     try {
         MPointer<double> ptr = MPointer<double>::New();
-        doublePointers.push_back(ptr);
+        doublePointers.push_back(std::move(ptr));
         updatePointerSelector();
         QMessageBox::information(this, "Success", "Created new double pointer");
     } catch (const std::exception& e) {
@@ -179,7 +180,7 @@ void MainWindow::onCreateDoublePointerClicked() {
 void MainWindow::onCreateStringPointerClicked() {
     try {
         MPointer<char[64]> ptr = MPointer<char[64]>::New();
-        stringPointers.push_back(ptr);
+        stringPointers.push_back(std::move(ptr));
         updatePointerSelector();
         QMessageBox::information(this, "Success", "Created new string pointer");
     } catch (const std::exception& e) {
@@ -301,11 +302,14 @@ void MainWindow::onLinkedListDisplayClicked() {
         ss << "List size: " << intList.getSize() << std::endl;
         ss << "Elements: ";
         
-        for (int i = 0; i < intList.getSize(); ++i) {
-            ss << intList.get(i);
-            if (i < intList.getSize() - 1) {
+        // Walk the list once, nodes are fetched in batches by the iterator
+        bool first = true;
+        for (int value : intList) {
+            if (!first) {
                 ss << " -> ";
             }
+            ss << value;
+            first = false;
         }
         
         listDisplayArea->setText(QString::fromStdString(ss.str()));